@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "account-storage-cache.h"
+
+#include <QDebug>
+
+#include <TelepathyQt/Account>
+
+#include <KAccounts/core.h>
+
+AccountStorageCache *AccountStorageCache::self()
+{
+    static AccountStorageCache cache;
+    return &cache;
+}
+
+AccountStorageCache::AccountStorageCache()
+{
+    Accounts::Manager *manager = KAccounts::accountsManager();
+    connect(manager, SIGNAL(accountCreated(Accounts::AccountId)),
+            SLOT(onStorageAccountCreated(Accounts::AccountId)));
+    connect(manager, SIGNAL(accountRemoved(Accounts::AccountId)),
+            SLOT(onStorageAccountRemoved(Accounts::AccountId)));
+}
+
+bool AccountStorageCache::lookup(const QString &accountPath, int *storageId, QString *provider) const
+{
+    QHash<QString, Entry>::const_iterator it = m_entries.constFind(accountPath);
+    if (it == m_entries.constEnd()) {
+        return false;
+    }
+
+    *storageId = it->storageId;
+    *provider = it->provider;
+    return true;
+}
+
+void AccountStorageCache::insert(const Tp::AccountPtr &account, int storageId, const QString &provider)
+{
+    // Another object may stand for the same account, e.g. once the
+    // previous one went away with its channels
+    QPointer<Tp::Account> &watched = m_watchedAccounts[account->objectPath()];
+    if (watched.data() != account.data()) {
+        connect(account.data(), SIGNAL(removed()), SLOT(onAccountRemoved()), Qt::UniqueConnection);
+        watched = account.data();
+    }
+
+    Entry entry;
+    entry.storageId = storageId;
+    entry.provider = provider;
+    m_entries.insert(account->objectPath(), entry);
+}
+
+void AccountStorageCache::onStorageAccountCreated(Accounts::AccountId id)
+{
+    Q_UNUSED(id);
+
+    // A new KAccounts account may now back any Telepathy account
+    m_entries.clear();
+}
+
+void AccountStorageCache::onStorageAccountRemoved(Accounts::AccountId id)
+{
+    QHash<QString, Entry>::iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        if (it->storageId == int(id)) {
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AccountStorageCache::onAccountRemoved()
+{
+    Tp::Account *account = qobject_cast<Tp::Account*>(sender());
+    if (account) {
+        m_entries.remove(account->objectPath());
+        m_watchedAccounts.remove(account->objectPath());
+    }
+}
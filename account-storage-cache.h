@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef ACCOUNT_STORAGE_CACHE_H
+#define ACCOUNT_STORAGE_CACHE_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+#include <TelepathyQt/Types>
+
+#include <Accounts/Manager>
+
+/**
+ * Process-wide map from Telepathy account object path to the storage
+ * identifier and provider of the account, as exposed by the Storage
+ * interface, so that every SASL channel does not have to ask the
+ * AccountManager again.
+ *
+ * Entries are dropped when KAccounts creates or removes accounts and when
+ * the Telepathy account is removed.
+ *
+ * Must only be used from the main thread.
+ */
+class AccountStorageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static AccountStorageCache *self();
+
+    bool lookup(const QString &accountPath, int *storageId, QString *provider) const;
+    void insert(const Tp::AccountPtr &account, int storageId, const QString &provider);
+
+private Q_SLOTS:
+    void onStorageAccountCreated(Accounts::AccountId id);
+    void onStorageAccountRemoved(Accounts::AccountId id);
+    void onAccountRemoved();
+
+private:
+    AccountStorageCache();
+    Q_DISABLE_COPY(AccountStorageCache)
+
+    struct Entry
+    {
+        int storageId;
+        QString provider;
+    };
+
+    QHash<QString, Entry> m_entries;
+    // The account objects whose removal is watched, by object path. They
+    // outlive the entries, which are dropped in bulk.
+    QHash<QString, QPointer<Tp::Account> > m_watchedAccounts;
+};
+
+#endif // ACCOUNT_STORAGE_CACHE_H
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "allocation-counter.h"
+
+#include <QAtomicInteger>
+
+#include <stdlib.h>
+
+// Plain static initialization, malloc is called before any constructor runs
+static QBasicAtomicInteger<quint64> s_allocations = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+#ifdef __GLIBC__
+
+// The executable's definitions take precedence over those of libc for
+// every library; glibc exports its own allocator under these names
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+    s_allocations.fetchAndAddRelaxed(1);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    s_allocations.fetchAndAddRelaxed(1);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (!ptr) {
+        s_allocations.fetchAndAddRelaxed(1);
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+}
+
+bool AllocationCounter::isAvailable()
+{
+    return true;
+}
+
+#else
+
+bool AllocationCounter::isAvailable()
+{
+    return false;
+}
+
+#endif
+
+quint64 AllocationCounter::count()
+{
+    return s_allocations.loadAcquire();
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <QtGlobal>
+
+/**
+ * Counts the heap allocations made by the whole process, Qt, QCA and
+ * OpenSSL included, by wrapping the glibc allocator.
+ */
+namespace AllocationCounter
+{
+    /**
+     * Whether allocations are counted, only on glibc.
+     */
+    bool isAvailable();
+
+    quint64 count();
+}
+
+#endif // ALLOCATION_COUNTER_H
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "benchmark-report.h"
+#include "allocation-counter.h"
+#include "peak-memory.h"
+#include "tls-timings.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <algorithm>
+
+BenchmarkReport::BenchmarkReport(int iterations)
+    : m_iterations(qMax(iterations, 1))
+{
+}
+
+void BenchmarkReport::run(const QString &name, const QJsonObject &params, const std::function<void()> &body)
+{
+    const bool peakReset = PeakMemory::reset();
+    body();
+
+    QVector<qint64> usecs;
+    usecs.reserve(m_iterations);
+    QElapsedTimer timer;
+    quint64 allocations = 0;
+    for (int i = 0; i < m_iterations; ++i) {
+        const quint64 allocationsBefore = AllocationCounter::count();
+        timer.start();
+        body();
+        usecs << TlsTimings::elapsedUSecs(timer);
+        allocations += AllocationCounter::count() - allocationsBefore;
+    }
+
+    std::sort(usecs.begin(), usecs.end());
+    qint64 total = 0;
+    Q_FOREACH (qint64 value, usecs) {
+        total += value;
+    }
+
+    QJsonObject result;
+    result.insert(QStringLiteral("name"), name);
+    result.insert(QStringLiteral("params"), params);
+    result.insert(QStringLiteral("iterations"), m_iterations);
+    result.insert(QStringLiteral("minUSecs"), usecs.first());
+    result.insert(QStringLiteral("medianUSecs"), usecs.at(usecs.size() / 2));
+    result.insert(QStringLiteral("meanUSecs"), total / usecs.size());
+    if (AllocationCounter::isAvailable()) {
+        result.insert(QStringLiteral("allocations"), qint64(allocations / m_iterations));
+    }
+    const qint64 peakKiB = peakReset ? PeakMemory::peakKiB() : -1;
+    if (peakKiB >= 0) {
+        result.insert(QStringLiteral("peakRssKiB"), peakKiB);
+    }
+    m_results << result;
+
+    qDebug() << name << QJsonDocument(params).toJson(QJsonDocument::Compact).constData()
+             << "median" << usecs.at(usecs.size() / 2) << "us";
+}
+
+void BenchmarkReport::skip(const QString &name, const QString &reason)
+{
+    QJsonObject result;
+    result.insert(QStringLiteral("name"), name);
+    result.insert(QStringLiteral("skipped"), reason);
+    m_results << result;
+
+    qDebug() << "Skipping" << name << "-" << reason;
+}
+
+QJsonDocument BenchmarkReport::toJson() const
+{
+    QJsonObject report;
+    report.insert(QStringLiteral("version"), 1);
+    report.insert(QStringLiteral("results"), m_results);
+    return QJsonDocument(report);
+}
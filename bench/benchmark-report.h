@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef BENCHMARK_REPORT_H
+#define BENCHMARK_REPORT_H
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+
+#include <functional>
+
+/**
+ * Runs the benchmark cases and collects their results as JSON, one
+ * object per case and set of parameters, so that runs of different
+ * releases can be compared.
+ */
+class BenchmarkReport
+{
+public:
+    explicit BenchmarkReport(int iterations);
+
+    /**
+     * Runs @p body once to warm up, then @p iterations times, recording
+     * the minimum, median and mean duration in microseconds and, where
+     * AllocationCounter is available, the allocations per run. On Linux
+     * the peak resident size of the process during the case is recorded
+     * as well.
+     */
+    void run(const QString &name, const QJsonObject &params, const std::function<void()> &body);
+
+    void skip(const QString &name, const QString &reason);
+
+    QJsonDocument toJson() const;
+
+private:
+    int m_iterations;
+    QJsonArray m_results;
+};
+
+#endif // BENCHMARK_REPORT_H
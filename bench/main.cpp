@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "benchmark-report.h"
+#include "synthetic-pki.h"
+
+#include "ca-issuer-index.h"
+#include "ca-store-snapshot.h"
+#include "certificate-rule-index.h"
+#include "crl-cache.h"
+#include "config-ktp-auth-handler.h"
+#ifdef HAVE_OPENSSL
+#include "openssl-verifier-backend.h"
+#endif
+#include "qca-support.h"
+#include "qca-verifier-backend.h"
+#include "tls-certificate.h"
+#include "tls-verification-cache.h"
+#include "tls-verifier-backend.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QSslCertificate>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include <ksslcertificatemanager.h>
+
+#include <QtCrypto>
+
+#include <algorithm>
+
+static QList<int> parseList(const QString &value)
+{
+    QList<int> list;
+    Q_FOREACH (const QString &item, value.split(QLatin1Char(','), QString::SkipEmptyParts)) {
+        bool ok = false;
+        const int number = item.trimmed().toInt(&ok);
+        if (ok && number > 0) {
+            list << number;
+        }
+    }
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+static TlsCertificateList handles(const CertificateDataList &chain)
+{
+    TlsCertificateList certificates;
+    for (int i = 0; i < chain.size(); ++i) {
+        certificates << TlsCertificate(chain, i);
+    }
+    return certificates;
+}
+
+static QByteArray revokedIssuerKeyId(int serial)
+{
+    // Spread over 16 issuers, like a handful of CAs publishing big CRLs
+    return QCryptographicHash::hash(QByteArray::number(serial % 16), QCryptographicHash::Sha1);
+}
+
+/**
+ * Writes @p count revoked certificates in the layout of the CRL cache
+ * records to @p file and maps it.
+ */
+static RevocationIndexPtr revocationIndex(QTemporaryFile *file, int count)
+{
+    QVector<QByteArray> keys;
+    keys.reserve(count);
+    for (int serial = 0; serial < count; ++serial) {
+        keys << RevocationIndex::key(revokedIssuerKeyId(serial), QString::number(serial));
+    }
+    std::sort(keys.begin(), keys.end());
+
+    if (!file->open()) {
+        qWarning() << "Unable to create the synthetic revocation index";
+        return RevocationIndexPtr();
+    }
+    Q_FOREACH (const QByteArray &key, keys) {
+        file->write(key);
+    }
+    file->flush();
+
+    const uchar *records = file->map(0, file->size());
+    if (!records) {
+        qWarning() << "Unable to map the synthetic revocation index";
+        return RevocationIndexPtr();
+    }
+
+    // The temporary file stays owned by the caller
+    return RevocationIndexPtr(new RevocationIndex(QSharedPointer<QFile>(), records, count));
+}
+
+static QJsonObject chainParams(const SyntheticPki &pki, int depth)
+{
+    QJsonObject params;
+    params.insert(QStringLiteral("keySize"), pki.keySize());
+    params.insert(QStringLiteral("depth"), depth);
+    return params;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("ktp-auth-handler-bench"));
+
+    // The snapshot and caches the benchmarked code writes end up under
+    // ~/.qttest instead of replacing those of the real handler
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Offline benchmarks of the TLS certificate verification"));
+    parser.addHelpOption();
+    const QCommandLineOption iterationsOption(QStringLiteral("iterations"),
+            QStringLiteral("Timed runs of every case."), QStringLiteral("count"), QStringLiteral("20"));
+    const QCommandLineOption bundleSizesOption(QStringLiteral("ca-bundle-sizes"),
+            QStringLiteral("Comma separated sizes of the synthetic CA bundle."), QStringLiteral("sizes"),
+            QStringLiteral("100,1000,10000"));
+    const QCommandLineOption depthsOption(QStringLiteral("depths"),
+            QStringLiteral("Comma separated chain depths, leaf and intermediates."), QStringLiteral("depths"),
+            QStringLiteral("1,2,3,4,5"));
+    const QCommandLineOption keySizesOption(QStringLiteral("key-sizes"),
+            QStringLiteral("Comma separated RSA key sizes of the synthetic chains."), QStringLiteral("bits"),
+            QStringLiteral("2048,4096"));
+    const QCommandLineOption crlEntriesOption(QStringLiteral("crl-entries"),
+            QStringLiteral("Revoked certificates in the synthetic revocation index."), QStringLiteral("count"),
+            QStringLiteral("100000"));
+    const QCommandLineOption concurrentChainsOption(QStringLiteral("concurrent-chains"),
+            QStringLiteral("Chains validated at once in the validation pool."), QStringLiteral("count"),
+            QStringLiteral("256"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+            QStringLiteral("Write the JSON results to this file instead of stdout."), QStringLiteral("file"));
+    parser.addOption(iterationsOption);
+    parser.addOption(bundleSizesOption);
+    parser.addOption(depthsOption);
+    parser.addOption(keySizesOption);
+    parser.addOption(crlEntriesOption);
+    parser.addOption(concurrentChainsOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const QList<int> bundleSizes = parseList(parser.value(bundleSizesOption));
+    const QList<int> depths = parseList(parser.value(depthsOption));
+    const QList<int> keySizes = parseList(parser.value(keySizesOption));
+    if (bundleSizes.isEmpty() || depths.isEmpty() || keySizes.isEmpty()) {
+        qWarning() << "Bundle sizes, depths and key sizes must not be empty";
+        return 1;
+    }
+
+    if (!QcaSupport::isCertSupported() || !QCA::isSupported("ca") || !QCA::isSupported("rsa")) {
+        qWarning() << "Generating the synthetic certificates needs the QCA OpenSSL plugin";
+        return 1;
+    }
+
+    QList<SyntheticPki> pkis;
+    Q_FOREACH (int keySize, keySizes) {
+        pkis << SyntheticPki(keySize, depths.last());
+    }
+
+    // Every bundle holds the synthetic roots, padded with unrelated CAs
+    QList<QByteArray> bundle;
+    Q_FOREACH (const SyntheticPki &pki, pkis) {
+        bundle << pki.root().toDER();
+    }
+    Q_FOREACH (const QCA::Certificate &ca, SyntheticPki::fillerCas(qMax(bundleSizes.last() - bundle.size(), 0))) {
+        bundle << ca.toDER();
+    }
+
+    BenchmarkReport report(parser.value(iterationsOption).toInt());
+
+    // Trust store loading, as the old CACollection() did it, as an issuer
+    // index and from a snapshot of that index
+    CaIssuerIndexPtr largestIndex;
+    QHash<int, CaIssuerIndexPtr> indexes;
+    Q_FOREACH (int size, bundleSizes) {
+        const QList<QByteArray> cas = bundle.mid(0, size);
+        QJsonObject params;
+        params.insert(QStringLiteral("bundleSize"), cas.size());
+
+        params.insert(QStringLiteral("variant"), QStringLiteral("collection"));
+        report.run(QStringLiteral("caCollection"), params, [&]() {
+            QCA::CertificateCollection collection;
+            Q_FOREACH (const QByteArray &der, cas) {
+                collection.addCertificate(QCA::Certificate::fromDER(der));
+            }
+        });
+
+        CaIssuerIndex *index = 0;
+        params.insert(QStringLiteral("variant"), QStringLiteral("issuerIndex"));
+        report.run(QStringLiteral("caCollection"), params, [&]() {
+            delete index;
+            index = new CaIssuerIndex;
+            Q_FOREACH (const QByteArray &der, cas) {
+                index->add(QCA::Certificate::fromDER(der));
+            }
+        });
+        largestIndex = CaIssuerIndexPtr(index);
+        indexes.insert(size, largestIndex);
+
+        const QByteArray stamp = QCryptographicHash::hash(QByteArray::number(size), QCryptographicHash::Sha256);
+        CaStoreSnapshot::save(stamp, *largestIndex);
+        params.insert(QStringLiteral("variant"), QStringLiteral("snapshotLoad"));
+        report.run(QStringLiteral("caCollection"), params, [&]() {
+            CaStoreSnapshot::load(stamp);
+        });
+    }
+    const quint64 caGeneration = bundleSizes.last();
+
+    // Validating against the whole bundle, and against only the CAs the
+    // index picks, which should stay flat as the bundle grows
+    Q_FOREACH (const SyntheticPki &pki, pkis) {
+        const int depth = depths.last();
+        const CertificateDataList chain = pki.chain(depth);
+        QCA::CertificateChain qcaChain;
+        for (int i = 0; i < chain.size(); ++i) {
+            qcaChain << QCA::Certificate::fromDER(chain.at(i));
+        }
+
+        Q_FOREACH (int size, bundleSizes) {
+            const CaIssuerIndexPtr index = indexes.value(size);
+            QCA::CertificateCollection collection;
+            Q_FOREACH (const QCA::Certificate &ca, index->certificates()) {
+                collection.addCertificate(ca);
+            }
+            QJsonObject params = chainParams(pki, depth);
+            params.insert(QStringLiteral("bundleSize"), index->size());
+
+            params.insert(QStringLiteral("variant"), QStringLiteral("fullCollection"));
+            report.run(QStringLiteral("issuerLookup"), params, [&]() {
+                qcaChain.validate(collection);
+            });
+
+            params.insert(QStringLiteral("variant"), QStringLiteral("issuerIndex"));
+            report.run(QStringLiteral("issuerLookup"), params, [&]() {
+                qcaChain.validate(index->issuersOf(qcaChain));
+            });
+        }
+    }
+
+    // Looked up the way the backends do, half of the queries are revoked
+    const int crlEntries = qMax(parser.value(crlEntriesOption).toInt(), 1);
+    QTemporaryFile revocationFile;
+    const RevocationIndexPtr revocations = revocationIndex(&revocationFile, crlEntries);
+    if (revocations.isNull()) {
+        return 1;
+    }
+    {
+        QJsonObject params;
+        params.insert(QStringLiteral("entries"), revocations->size());
+        params.insert(QStringLiteral("lookups"), 1000);
+        report.run(QStringLiteral("revocation"), params, [&]() {
+            for (int i = 0; i < 1000; ++i) {
+                const int serial = i % 2 ? i : crlEntries + i;
+                revocations->isRevoked(revokedIssuerKeyId(serial), QString::number(serial));
+            }
+        });
+    }
+
+    QcaVerifierBackend qcaBackend;
+    QList<TlsVerifierBackend*> backends;
+    backends << &qcaBackend;
+#ifdef HAVE_OPENSSL
+    OpenSslVerifierBackend openSslBackend;
+    backends << &openSslBackend;
+#endif
+    const bool haveRuleStore = QDBusConnection::sessionBus().isConnected();
+
+    Q_FOREACH (const SyntheticPki &pki, pkis) {
+        Q_FOREACH (int depth, depths) {
+            const CertificateDataList chain = pki.chain(depth);
+            QJsonObject params = chainParams(pki, depth);
+
+            // The DER round trips the verifier op used to make: QCA and back
+            // for the leaf, then again for every link of the chain
+            params.insert(QStringLiteral("variant"), QStringLiteral("roundTrip"));
+            report.run(QStringLiteral("parse"), params, [&]() {
+                const QCA::Certificate leaf = QCA::Certificate::fromDER(chain.at(0));
+                QSslCertificate(leaf.toDER(), QSsl::Der);
+                QCA::CertificateChain qcaChain;
+                for (int i = 0; i < chain.size(); ++i) {
+                    qcaChain << QCA::Certificate::fromDER(chain.at(i));
+                }
+            });
+
+            // Building the handles and the views the verifier op uses
+            params.insert(QStringLiteral("variant"), QStringLiteral("handle"));
+            report.run(QStringLiteral("parse"), params, [&]() {
+                const TlsCertificateList certificates = handles(chain);
+                certificates.first().sslCertificate();
+                Q_FOREACH (const TlsCertificate &cert, certificates) {
+                    cert.qcaCertificate();
+                }
+            });
+
+            // The QSslCertificate list shown by the trust prompt
+            QCA::CertificateChain qcaChain;
+            for (int i = 0; i < chain.size(); ++i) {
+                qcaChain << QCA::Certificate::fromDER(chain.at(i));
+            }
+            params.insert(QStringLiteral("variant"), QStringLiteral("roundTrip"));
+            report.run(QStringLiteral("chainToList"), params, [&]() {
+                QList<QSslCertificate> list;
+                Q_FOREACH (const QCA::Certificate &cert, qcaChain) {
+                    list << QSslCertificate(cert.toDER(), QSsl::Der);
+                }
+            });
+
+            params.insert(QStringLiteral("variant"), QStringLiteral("handle"));
+            report.run(QStringLiteral("chainToList"), params, [&]() {
+                QList<QSslCertificate> list;
+                Q_FOREACH (const TlsCertificate &cert, handles(chain)) {
+                    list << cert.sslCertificate();
+                }
+            });
+            params.remove(QStringLiteral("variant"));
+
+            // Every backend goes through the same chains and bundle
+            const QString hostname = QStringLiteral("depth%1.bench.example.org").arg(depth);
+            params.insert(QStringLiteral("bundleSize"), largestIndex->size());
+            Q_FOREACH (TlsVerifierBackend *backend, backends) {
+                params.insert(QStringLiteral("backend"), backend->name());
+                const QCA::Validity validity = backend->validate(handles(chain), largestIndex,
+                                                                 caGeneration, RevocationIndexPtr()).validity;
+                if (validity != QCA::ValidityGood) {
+                    qWarning() << "Synthetic chain did not validate with" << backend->name() << ":" << validity;
+                }
+                params.remove(QStringLiteral("variant"));
+                params.remove(QStringLiteral("ruleLookup"));
+                report.run(QStringLiteral("validate"), params, [&]() {
+                    backend->validate(handles(chain), largestIndex, caGeneration, RevocationIndexPtr());
+                });
+
+                params.insert(QStringLiteral("revocationEntries"), revocations->size());
+                report.run(QStringLiteral("validate"), params, [&]() {
+                    backend->validate(handles(chain), largestIndex, caGeneration, revocations);
+                });
+                params.remove(QStringLiteral("revocationEntries"));
+
+                // What TlsCertVerifierOp does for a chain it has not seen recently
+                params.insert(QStringLiteral("variant"), QStringLiteral("validated"));
+                params.insert(QStringLiteral("ruleLookup"), haveRuleStore);
+                report.run(QStringLiteral("endToEnd"), params, [&]() {
+                    TlsVerificationCache::key(chain, hostname);
+                    const TlsCertificateList certificates = handles(chain);
+                    if (haveRuleStore) {
+                        CertificateRuleIndex::self()->rule(certificates.first().sslCertificate(), hostname);
+                    }
+                    QcaSupport::isCertSupported();
+                    backend->validate(certificates, largestIndex, caGeneration, RevocationIndexPtr());
+                });
+            }
+            params.remove(QStringLiteral("backend"));
+
+            // and for one it accepted a moment ago
+            TlsVerificationCache::self()->insertAccepted(TlsVerificationCache::key(chain, hostname), caGeneration);
+            params.insert(QStringLiteral("variant"), QStringLiteral("cached"));
+            params.remove(QStringLiteral("ruleLookup"));
+            report.run(QStringLiteral("endToEnd"), params, [&]() {
+                TlsVerificationCache::self()->isAccepted(TlsVerificationCache::key(chain, hostname), caGeneration);
+            });
+        }
+    }
+
+    // A burst of channels, e.g. many accounts reconnecting after a
+    // resume: the pool bounds the work in flight, the peak RSS shows
+    // whether the memory stays bounded with it
+    const int concurrentChains = qMax(parser.value(concurrentChainsOption).toInt(), 1);
+    Q_FOREACH (const SyntheticPki &pki, pkis) {
+        const int depth = depths.last();
+        const CertificateDataList chain = pki.chain(depth);
+        QJsonObject params = chainParams(pki, depth);
+        params.insert(QStringLiteral("bundleSize"), largestIndex->size());
+        params.insert(QStringLiteral("revocationEntries"), revocations->size());
+        params.insert(QStringLiteral("chains"), concurrentChains);
+        params.insert(QStringLiteral("threads"), TlsVerifierBackend::pool()->maxThreadCount());
+        Q_FOREACH (TlsVerifierBackend *backend, backends) {
+            params.insert(QStringLiteral("backend"), backend->name());
+            report.run(QStringLiteral("concurrentValidate"), params, [&]() {
+                QList<QFuture<TlsChainValidation> > futures;
+                for (int i = 0; i < concurrentChains; ++i) {
+                    futures << QtConcurrent::run(TlsVerifierBackend::pool(), backend, &TlsVerifierBackend::validate,
+                                                 handles(chain), largestIndex, caGeneration, revocations);
+                }
+                Q_FOREACH (QFuture<TlsChainValidation> future, futures) {
+                    future.waitForFinished();
+                }
+            });
+        }
+    }
+
+    // Rules are stored by kssld, which needs a session bus
+    if (haveRuleStore) {
+        const QSslCertificate leaf = TlsCertificate(pkis.first().chain(1), 0).sslCertificate();
+        const QString hostname = QStringLiteral("depth1.bench.example.org");
+        QJsonObject params;
+
+        params.insert(QStringLiteral("variant"), QStringLiteral("manager"));
+        report.run(QStringLiteral("ruleLookup"), params, [&]() {
+            KSslCertificateManager::self()->rule(leaf, hostname);
+        });
+
+        params.insert(QStringLiteral("variant"), QStringLiteral("index"));
+        report.run(QStringLiteral("ruleLookup"), params, [&]() {
+            CertificateRuleIndex::self()->rule(leaf, hostname);
+        });
+    } else {
+        report.skip(QStringLiteral("ruleLookup"), QStringLiteral("no D-Bus session bus"));
+    }
+
+    const QByteArray json = report.toJson().toJson();
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+            qWarning() << "Unable to write the results to" << file.fileName();
+            return 1;
+        }
+    } else {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(json);
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "peak-memory.h"
+
+#include <QByteArray>
+#include <QFile>
+
+bool PeakMemory::reset()
+{
+    // Linux 4.0 and later reset VmHWM when "5" is written here
+    QFile file(QStringLiteral("/proc/self/clear_refs"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write("5") == 1;
+}
+
+qint64 PeakMemory::peakKiB()
+{
+    QFile file(QStringLiteral("/proc/self/status"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    // The line reads e.g. "VmHWM:     12345 kB"
+    Q_FOREACH (const QByteArray &line, file.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:")) {
+            const QList<QByteArray> fields = line.mid(6).simplified().split(' ');
+            bool ok = false;
+            const qint64 value = fields.first().toLongLong(&ok);
+            return ok ? value : -1;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PEAK_MEMORY_H
+#define PEAK_MEMORY_H
+
+#include <QtGlobal>
+
+/**
+ * High-water mark of the resident memory of the process, as reported by
+ * Linux in /proc/self/status.
+ */
+namespace PeakMemory
+{
+    /**
+     * Lowers the high-water mark to the current resident size, returns
+     * false where that is not supported.
+     */
+    bool reset();
+
+    /**
+     * The highest resident size since the last reset(), in KiB, or -1 if
+     * unknown.
+     */
+    qint64 peakKiB();
+}
+
+#endif // PEAK_MEMORY_H
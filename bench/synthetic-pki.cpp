@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "synthetic-pki.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+SyntheticPki::SyntheticPki(int keySize, int maxDepth)
+    : m_keySize(keySize)
+{
+    QCA::KeyGenerator generator;
+    const QString prefix = QStringLiteral("Synthetic RSA-%1 ").arg(keySize);
+    int serial = 1;
+
+    QCA::PrivateKey issuerKey = generator.createRSA(keySize);
+    m_root = QCA::Certificate(options(prefix + QLatin1String("Root CA"), serial++, true), issuerKey);
+    QCA::Certificate issuer = m_root;
+
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        const QCA::CertificateAuthority authority(issuer, issuerKey);
+
+        const QCA::PrivateKey leafKey = generator.createRSA(keySize);
+        m_leaves << authority.createCertificate(leafKey.toPublicKey(),
+                options(QStringLiteral("depth%1.bench.example.org").arg(depth), serial++, false));
+
+        if (depth < maxDepth) {
+            const QCA::PrivateKey key = generator.createRSA(keySize);
+            const QCA::Certificate intermediate = authority.createCertificate(key.toPublicKey(),
+                    options(prefix + QStringLiteral("Intermediate CA %1").arg(depth), serial++, true));
+            m_intermediates << intermediate;
+            issuer = intermediate;
+            issuerKey = key;
+        }
+    }
+
+    qDebug() << "Generated a synthetic PKI with RSA-" << keySize << "keys and chains up to" << maxDepth << "deep";
+}
+
+int SyntheticPki::keySize() const
+{
+    return m_keySize;
+}
+
+QCA::Certificate SyntheticPki::root() const
+{
+    return m_root;
+}
+
+CertificateDataList SyntheticPki::chain(int depth) const
+{
+    CertificateDataList chain;
+    chain.append(m_leaves.at(depth - 1).toDER());
+    for (int i = depth - 2; i >= 0; --i) {
+        chain.append(m_intermediates.at(i).toDER());
+    }
+    return chain;
+}
+
+QList<QCA::Certificate> SyntheticPki::fillerCas(int count)
+{
+    // Only the subjects have to differ, signing with a single key keeps
+    // generating thousands of them fast
+    const QCA::PrivateKey key = QCA::KeyGenerator().createRSA(2048);
+
+    QList<QCA::Certificate> cas;
+    for (int i = 0; i < count; ++i) {
+        cas << QCA::Certificate(options(QStringLiteral("Synthetic Filler CA %1").arg(i), i + 1, true), key);
+    }
+    return cas;
+}
+
+QCA::CertificateOptions SyntheticPki::options(const QString &commonName, int serial, bool isCa)
+{
+    QCA::CertificateInfo info;
+    info.insert(QCA::CommonName, commonName);
+    info.insert(QCA::Organization, QStringLiteral("KDE Telepathy Benchmarks"));
+
+    QCA::CertificateOptions opts;
+    opts.setInfo(info);
+    opts.setSerialNumber(QCA::BigInteger(serial));
+    opts.setValidityPeriod(QDateTime::currentDateTime().addDays(-1),
+                           QDateTime::currentDateTime().addYears(1));
+
+    QCA::Constraints constraints;
+    if (isCa) {
+        opts.setAsCA();
+        constraints << QCA::KeyCertificateSign << QCA::CRLSign;
+    } else {
+        info.insert(QCA::DNS, commonName);
+        opts.setInfo(info);
+        constraints << QCA::DigitalSignature << QCA::KeyEncipherment << QCA::ServerAuth;
+    }
+    opts.setConstraints(constraints);
+
+    return opts;
+}
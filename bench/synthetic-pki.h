@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SYNTHETIC_PKI_H
+#define SYNTHETIC_PKI_H
+
+#include <QList>
+#include <QString>
+
+#include <QtCrypto>
+
+#include "types.h"
+
+/**
+ * Certificates generated on the fly with QCA, so that the benchmarks run
+ * offline and never depend on the trust store of the machine.
+ *
+ * A PKI is a root CA, a ladder of intermediates below it and one leaf
+ * per chain depth, all with RSA keys of the same size.
+ */
+class SyntheticPki
+{
+public:
+    SyntheticPki(int keySize, int maxDepth);
+
+    int keySize() const;
+    QCA::Certificate root() const;
+
+    /**
+     * The chain a server would send for @p depth, leaf first: the leaf and
+     * the @p depth - 1 intermediates above it, without the root.
+     */
+    CertificateDataList chain(int depth) const;
+
+    /**
+     * @p count self-signed CAs unrelated to any synthetic chain, to pad
+     * CA bundles to a given size.
+     */
+    static QList<QCA::Certificate> fillerCas(int count);
+
+private:
+    static QCA::CertificateOptions options(const QString &commonName, int serial, bool isCa);
+
+    int m_keySize;
+    QCA::Certificate m_root;
+    // m_intermediates[i] is issued by m_intermediates[i - 1], the first by the root
+    QList<QCA::Certificate> m_intermediates;
+    // m_leaves[d - 1] is issued by the CA d - 1 levels below the root
+    QList<QCA::Certificate> m_leaves;
+};
+
+#endif // SYNTHETIC_PKI_H
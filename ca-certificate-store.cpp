@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ca-certificate-store.h"
+#include "ca-store-snapshot.h"
+#include "qca-support.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSslConfiguration>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+CaCertificateStore *CaCertificateStore::self()
+{
+    static CaCertificateStore store;
+    return &store;
+}
+
+CaCertificateStore::CaCertificateStore()
+    : m_generation(0),
+      m_hits(0),
+      m_rebuilds(0)
+{
+    QcaSupport::initialize();
+
+    // Package updates rewrite several sources at once, coalesce them
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(1000);
+    connect(&m_refreshTimer, SIGNAL(timeout()), SLOT(refresh()));
+
+    connect(&m_watcher, SIGNAL(fileChanged(QString)), SLOT(onSourceChanged(QString)));
+    connect(&m_watcher, SIGNAL(directoryChanged(QString)), SLOT(onSourceChanged(QString)));
+    watchSources();
+}
+
+CaIssuerIndexPtr CaCertificateStore::issuerIndex()
+{
+    if (m_index.isNull()) {
+        rebuild(CaStoreSnapshot::sourceStamp());
+    } else if (m_refreshTimer.isActive()) {
+        // A source changed, don't verify against the old CA set
+        m_refreshTimer.stop();
+        refresh();
+    } else {
+        ++m_hits;
+    }
+
+    qDebug() << "CA store cache: hits" << m_hits << "rebuilds" << m_rebuilds;
+
+    return m_index;
+}
+
+quint64 CaCertificateStore::generation() const
+{
+    return m_generation;
+}
+
+quint64 CaCertificateStore::hits() const
+{
+    return m_hits;
+}
+
+quint64 CaCertificateStore::rebuilds() const
+{
+    return m_rebuilds;
+}
+
+void CaCertificateStore::onSourceChanged(const QString &path)
+{
+    // Files replaced by a rename drop out of the watcher
+    if (!m_watcher.files().contains(path) && QFileInfo(path).isFile()) {
+        m_watcher.addPath(path);
+    }
+
+    m_refreshTimer.start();
+}
+
+void CaCertificateStore::refresh()
+{
+    watchSources();
+
+    const QByteArray stamp = CaStoreSnapshot::sourceStamp();
+    if (stamp == m_stamp) {
+        return;
+    }
+
+    if (m_index.isNull()) {
+        rebuild(stamp);
+    } else {
+        applyChanges(stamp);
+    }
+}
+
+void CaCertificateStore::watchSources()
+{
+    const QStringList watched = m_watcher.files() + m_watcher.directories();
+    Q_FOREACH (const QString &path, CaStoreSnapshot::sources()) {
+        if (!watched.contains(path) && QFileInfo(path).exists()) {
+            m_watcher.addPath(path);
+        }
+    }
+}
+
+QList<QSslCertificate> CaCertificateStore::readCaCertificates()
+{
+    // Same set as KSslCertificateManager::caCertificates(), read from the
+    // sources every time: KIO loads it once per process and would never
+    // show changes made while the handler runs
+    QList<QSslCertificate> candidates = QSslConfiguration::systemCaCertificates();
+
+    const QFileInfoList userFiles = QDir(CaStoreSnapshot::userCaDirectory()).entryInfoList(QDir::Files);
+    Q_FOREACH (const QFileInfo &info, userFiles) {
+        QFile file(info.absoluteFilePath());
+        if (file.open(QIODevice::ReadOnly)) {
+            candidates << QSslCertificate::fromData(file.readAll(), QSsl::Pem);
+        }
+    }
+
+    KConfig config(QStringLiteral("ksslcablacklist"), KConfig::SimpleConfig);
+    const KConfigGroup blacklist = config.group(QStringLiteral("Blacklist of CA Certificates"));
+
+    QList<QSslCertificate> certs;
+    Q_FOREACH (const QSslCertificate &cert, candidates) {
+        if (!blacklist.hasKey(QString::fromLatin1(cert.digest().toHex()))) {
+            certs << cert;
+        }
+    }
+    return certs;
+}
+
+void CaCertificateStore::rebuild(const QByteArray &stamp)
+{
+    // A snapshot left by an earlier activation saves parsing every CA
+    CaIssuerIndexPtr index = CaStoreSnapshot::load(stamp);
+    if (index.isNull()) {
+        QSharedPointer<CaIssuerIndex> parsed(new CaIssuerIndex);
+        Q_FOREACH (const QSslCertificate &cert, readCaCertificates()) {
+            parsed->add(QCA::Certificate::fromDER(cert.toDer()));
+        }
+        CaStoreSnapshot::save(stamp, *parsed);
+        index = parsed;
+    } else {
+        qDebug() << "Using the CA store snapshot with" << index->size() << "certificates";
+    }
+
+    m_stamp = stamp;
+    m_index = index;
+    ++m_generation;
+    ++m_rebuilds;
+}
+
+void CaCertificateStore::applyChanges(const QByteArray &stamp)
+{
+    QHash<QByteArray, int> current;
+    for (int i = 0; i < m_index->size(); ++i) {
+        current.insert(QCryptographicHash::hash(m_index->der(i), QCryptographicHash::Sha256), i);
+    }
+
+    QSharedPointer<CaIssuerIndex> index(new CaIssuerIndex);
+    int added = 0;
+    Q_FOREACH (const QSslCertificate &cert, readCaCertificates()) {
+        const QByteArray der = cert.toDer();
+        const QByteArray digest = QCryptographicHash::hash(der, QCryptographicHash::Sha256);
+        if (current.contains(digest)) {
+            index->addFrom(*m_index, current.take(digest));
+        } else {
+            index->add(QCA::Certificate::fromDER(der));
+            ++added;
+        }
+    }
+    const int removed = current.size();
+
+    m_stamp = stamp;
+    if (added == 0 && removed == 0) {
+        return;
+    }
+
+    qDebug() << "CA store changed:" << added << "added," << removed << "removed";
+
+    CaStoreSnapshot::save(stamp, *index);
+    m_index = index;
+    ++m_generation;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CA_CERTIFICATE_STORE_H
+#define CA_CERTIFICATE_STORE_H
+
+#include <QByteArray>
+#include <QFileSystemWatcher>
+#include <QList>
+#include <QObject>
+#include <QSslCertificate>
+#include <QTimer>
+
+#include "ca-issuer-index.h"
+
+/**
+ * Process-wide cache of the trusted CA certificates, parsed into a
+ * CaIssuerIndex once and shared by all TLS verifier ops.
+ *
+ * The trust store sources are watched; when one changes, only the CAs
+ * that were added are parsed, the rest are carried over from the current
+ * index. The first index comes preferably from the snapshot left by an
+ * earlier activation. Every change bumps generation().
+ *
+ * Must only be used from the main thread.
+ */
+class CaCertificateStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static CaCertificateStore *self();
+
+    CaIssuerIndexPtr issuerIndex();
+
+    quint64 generation() const;
+    quint64 hits() const;
+    quint64 rebuilds() const;
+
+private Q_SLOTS:
+    void onSourceChanged(const QString &path);
+    void refresh();
+
+private:
+    CaCertificateStore();
+    Q_DISABLE_COPY(CaCertificateStore)
+
+    static QList<QSslCertificate> readCaCertificates();
+
+    void watchSources();
+    void rebuild(const QByteArray &stamp);
+    void applyChanges(const QByteArray &stamp);
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_refreshTimer;
+    QByteArray m_stamp;
+    CaIssuerIndexPtr m_index;
+    quint64 m_generation;
+    quint64 m_hits;
+    quint64 m_rebuilds;
+};
+
+#endif // CA_CERTIFICATE_STORE_H
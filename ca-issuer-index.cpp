@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ca-issuer-index.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QSet>
+
+CaIssuerIndex::CaIssuerIndex()
+{
+}
+
+void CaIssuerIndex::add(const QCA::Certificate &cert)
+{
+    if (cert.isNull()) {
+        return;
+    }
+
+    Entry entry;
+    entry.der = cert.toDER();
+    entry.subject = cert.subjectInfoOrdered().toString();
+    entry.subjectKeyId = cert.subjectKeyId();
+    index(entry);
+
+    m_parsed.last() = cert;
+    m_parseState.last() = Parsed;
+}
+
+void CaIssuerIndex::add(const QByteArray &der, const QString &subject, const QByteArray &subjectKeyId)
+{
+    Entry entry;
+    entry.der = der;
+    entry.subject = subject;
+    entry.subjectKeyId = subjectKeyId;
+    index(entry);
+}
+
+void CaIssuerIndex::addFrom(const CaIssuerIndex &other, int index)
+{
+    this->index(other.m_entries.at(index));
+
+    {
+        QMutexLocker locker(&other.m_parsedMutex);
+        m_parsed.last() = other.m_parsed.at(index);
+        m_parseState.last() = other.m_parseState.at(index);
+    }
+
+    if (!other.m_backingFile.isNull()) {
+        m_backingFile = other.m_backingFile;
+    }
+}
+
+void CaIssuerIndex::setBackingFile(const QSharedPointer<QFile> &file)
+{
+    m_backingFile = file;
+}
+
+int CaIssuerIndex::size() const
+{
+    return m_entries.size();
+}
+
+QByteArray CaIssuerIndex::der(int index) const
+{
+    return m_entries.at(index).der;
+}
+
+QString CaIssuerIndex::subject(int index) const
+{
+    return m_entries.at(index).subject;
+}
+
+QByteArray CaIssuerIndex::subjectKeyId(int index) const
+{
+    return m_entries.at(index).subjectKeyId;
+}
+
+QList<QCA::Certificate> CaIssuerIndex::certificates() const
+{
+    QList<QCA::Certificate> certs;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        const QCA::Certificate cert = certificate(i);
+        if (!cert.isNull()) {
+            certs << cert;
+        }
+    }
+    return certs;
+}
+
+QCA::CertificateCollection CaIssuerIndex::issuersOf(const QCA::CertificateChain &chain) const
+{
+    QSet<int> matches;
+    QList<int> pending;
+    Q_FOREACH (const QCA::Certificate &cert, chain) {
+        pending << matchIssuers(cert, matches);
+    }
+
+    // A CA of the store can itself be cross-signed or intermediate, follow
+    // its issuers until reaching self-signed ones so the path can be built
+    QCA::CertificateCollection issuers;
+    while (!pending.isEmpty()) {
+        const QCA::Certificate cert = certificate(pending.takeFirst());
+        if (cert.isNull()) {
+            continue;
+        }
+
+        issuers.addCertificate(cert);
+        if (!cert.isSelfSigned()) {
+            pending << matchIssuers(cert, matches);
+        }
+    }
+
+    return issuers;
+}
+
+QList<int> CaIssuerIndex::matchIssuers(const QCA::Certificate &cert, QSet<int> &matches) const
+{
+    QList<int> found;
+    Q_FOREACH (int index, m_bySubject.values(cert.issuerInfoOrdered().toString())) {
+        if (!matches.contains(index)) {
+            matches.insert(index);
+            found << index;
+        }
+    }
+
+    // Also catches issuers whose name is encoded differently from the
+    // issuer field of the certificate they signed
+    const QByteArray authorityKeyId = cert.issuerKeyId();
+    if (!authorityKeyId.isEmpty()) {
+        Q_FOREACH (int index, m_bySubjectKeyId.values(authorityKeyId)) {
+            if (!matches.contains(index)) {
+                matches.insert(index);
+                found << index;
+            }
+        }
+    }
+
+    return found;
+}
+
+void CaIssuerIndex::index(const Entry &entry)
+{
+    const int index = m_entries.size();
+    m_entries << entry;
+    m_parsed.resize(m_entries.size());
+    m_parseState.resize(m_entries.size());
+
+    m_bySubject.insert(entry.subject, index);
+    if (!entry.subjectKeyId.isEmpty()) {
+        m_bySubjectKeyId.insert(entry.subjectKeyId, index);
+    }
+}
+
+QCA::Certificate CaIssuerIndex::certificate(int index) const
+{
+    {
+        QMutexLocker locker(&m_parsedMutex);
+        if (m_parseState.at(index) != Unparsed) {
+            return m_parsed.at(index);
+        }
+    }
+
+    // Two threads may end up parsing the same CA, which is cheaper than
+    // making every other lookup wait for the parse
+    const QCA::Certificate cert = QCA::Certificate::fromDER(m_entries.at(index).der);
+
+    QMutexLocker locker(&m_parsedMutex);
+    if (m_parseState.at(index) == Unparsed) {
+        m_parsed[index] = cert;
+        m_parseState[index] = cert.isNull() ? ParseFailed : Parsed;
+    }
+    return m_parsed.at(index);
+}
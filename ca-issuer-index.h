@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CA_ISSUER_INDEX_H
+#define CA_ISSUER_INDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <QtCrypto>
+
+class QFile;
+
+/**
+ * The trusted CA certificates, indexed by subject name and subject key
+ * identifier.
+ *
+ * Validating against the whole trust store makes the crypto backend look
+ * through every CA for every link of the chain; issuersOf() instead picks
+ * the few CAs that can possibly have issued a link in constant time, and
+ * only those are handed to QCA for validation.
+ *
+ * Entries can also be added as raw DER together with their precomputed
+ * index keys, e.g. straight from a memory-mapped snapshot, in which case
+ * they are only parsed by QCA once a chain actually needs them.
+ *
+ * Not modified once built, so it can be shared with the validation pool.
+ */
+class CaIssuerIndex
+{
+public:
+    CaIssuerIndex();
+
+    void add(const QCA::Certificate &cert);
+    void add(const QByteArray &der, const QString &subject, const QByteArray &subjectKeyId);
+
+    /**
+     * Copies entry @p index of @p other, including its parsed certificate
+     * and the file backing its DER, so it does not have to be parsed again.
+     */
+    void addFrom(const CaIssuerIndex &other, int index);
+
+    /**
+     * Keeps @p file open and mapped for as long as the index lives, for
+     * entries whose DER points into that mapping.
+     */
+    void setBackingFile(const QSharedPointer<QFile> &file);
+
+    int size() const;
+    QByteArray der(int index) const;
+    QString subject(int index) const;
+    QByteArray subjectKeyId(int index) const;
+    QList<QCA::Certificate> certificates() const;
+
+    /**
+     * Returns the CAs whose subject matches the issuer of any link of
+     * @p chain, and transitively the issuers of those that are not
+     * self-signed, which is all a chain can be validated against.
+     */
+    QCA::CertificateCollection issuersOf(const QCA::CertificateChain &chain) const;
+
+private:
+    Q_DISABLE_COPY(CaIssuerIndex)
+
+    struct Entry
+    {
+        QByteArray der;
+        QString subject;
+        QByteArray subjectKeyId;
+    };
+
+    void index(const Entry &entry);
+    // Adds the not yet seen CAs that may have issued @p cert to @p matches
+    // and returns them
+    QList<int> matchIssuers(const QCA::Certificate &cert, QSet<int> &matches) const;
+    QCA::Certificate certificate(int index) const;
+
+    QVector<Entry> m_entries;
+    QMultiHash<QString, int> m_bySubject;
+    QMultiHash<QByteArray, int> m_bySubjectKeyId;
+    QSharedPointer<QFile> m_backingFile;
+
+    enum ParseState
+    {
+        Unparsed,
+        Parsed,
+        // Not retried, the DER will not get any better
+        ParseFailed
+    };
+
+    // Lazily parsed certificates, shared by the validation threads. The
+    // mutex only guards the slots, parsing happens outside of it.
+    mutable QMutex m_parsedMutex;
+    mutable QVector<QCA::Certificate> m_parsed;
+    mutable QVector<ParseState> m_parseState;
+};
+
+typedef QSharedPointer<const CaIssuerIndex> CaIssuerIndexPtr;
+
+#endif // CA_ISSUER_INDEX_H
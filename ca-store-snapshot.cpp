@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ca-store-snapshot.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <string.h>
+
+/*
+ * Layout, all integers in host byte order:
+ *
+ *   Header
+ *   Record[count]
+ *   blob area holding the DER, subject (UTF-8) and subject key id bytes
+ *
+ * Offsets in records are relative to the start of the file.
+ */
+
+static const quint32 s_magic = 0x4b545043; // "KTPC"
+static const quint32 s_version = 1;
+
+struct Header
+{
+    quint32 magic;
+    quint32 version;
+    char stamp[32];
+    quint32 count;
+    quint32 reserved;
+};
+
+struct Record
+{
+    quint32 derOffset;
+    quint32 derLength;
+    quint32 subjectOffset;
+    quint32 subjectLength;
+    quint32 subjectKeyIdOffset;
+    quint32 subjectKeyIdLength;
+};
+
+static QString snapshotFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + QLatin1String("/ca-store-snapshot");
+}
+
+QString CaStoreSnapshot::userCaDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+            + QLatin1String("/kssl/userCaCertificates");
+}
+
+// Where QSslConfiguration::systemCaCertificates() reads the system CAs
+// from on Unix: the *.pem and *.crt files of these directories...
+static QStringList systemCaDirectories()
+{
+    QStringList directories;
+    directories << QStringLiteral("/etc/ssl/certs")
+                << QStringLiteral("/usr/lib/ssl/certs")
+                << QStringLiteral("/usr/share/ssl")
+                << QStringLiteral("/usr/local/ssl")
+                << QStringLiteral("/var/ssl/certs")
+                << QStringLiteral("/usr/local/ssl/certs")
+                << QStringLiteral("/etc/openssl/certs")
+                << QStringLiteral("/opt/openssl/certs")
+                << QStringLiteral("/etc/ssl");
+    return directories;
+}
+
+// ...and these bundles
+static QStringList systemCaBundles()
+{
+    QStringList bundles;
+    bundles << QStringLiteral("/etc/pki/tls/certs/ca-bundle.crt")
+            << QStringLiteral("/usr/local/share/certs/ca-root-nss.crt");
+    return bundles;
+}
+
+static QString blacklistFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+            + QLatin1String("/ksslcablacklist");
+}
+
+QStringList CaStoreSnapshot::sources()
+{
+    // Adding or removing a certificate changes its directory
+    return systemCaDirectories() + systemCaBundles()
+            << userCaDirectory() << blacklistFileName();
+}
+
+QByteArray CaStoreSnapshot::sourceStamp()
+{
+    // Every file readCaCertificates() reads, once even if it is linked to
+    // from several places
+    QSet<QString> files;
+    Q_FOREACH (const QString &directory, systemCaDirectories()) {
+        const QFileInfoList infos = QDir(directory).entryInfoList(
+                QStringList() << QStringLiteral("*.pem") << QStringLiteral("*.crt"), QDir::Files);
+        Q_FOREACH (const QFileInfo &info, infos) {
+            files.insert(info.canonicalFilePath());
+        }
+    }
+    Q_FOREACH (const QFileInfo &info, QDir(userCaDirectory()).entryInfoList(QDir::Files)) {
+        files.insert(info.canonicalFilePath());
+    }
+    Q_FOREACH (const QString &path, systemCaBundles() << blacklistFileName()) {
+        files.insert(QFileInfo(path).canonicalFilePath());
+    }
+    // Missing files have no canonical path
+    files.remove(QString());
+
+    QStringList sorted = files.toList();
+    sorted.sort();
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArray::number(s_version));
+    Q_FOREACH (const QString &path, sorted) {
+        const QFileInfo info(path);
+        hash.addData(path.toUtf8());
+        hash.addData(QByteArray::number(info.size()));
+        hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+        hash.addData("\0", 1);
+    }
+
+    return hash.result();
+}
+
+CaIssuerIndexPtr CaStoreSnapshot::load(const QByteArray &stamp)
+{
+    QSharedPointer<QFile> file(new QFile(snapshotFileName()));
+    if (!file->open(QIODevice::ReadOnly)) {
+        return CaIssuerIndexPtr();
+    }
+
+    const qint64 size = file->size();
+    if (size < qint64(sizeof(Header))) {
+        return CaIssuerIndexPtr();
+    }
+
+    const uchar *data = file->map(0, size);
+    if (!data) {
+        qWarning() << "Unable to map the CA store snapshot" << file->fileName();
+        return CaIssuerIndexPtr();
+    }
+
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != s_magic || header.version != s_version
+            || stamp.size() != int(sizeof(header.stamp))
+            || memcmp(header.stamp, stamp.constData(), sizeof(header.stamp)) != 0) {
+        qDebug() << "CA store snapshot is out of date";
+        return CaIssuerIndexPtr();
+    }
+
+    if (header.count > (size - sizeof(Header)) / sizeof(Record)) {
+        qWarning() << "Ignoring truncated CA store snapshot" << file->fileName();
+        return CaIssuerIndexPtr();
+    }
+
+    QSharedPointer<CaIssuerIndex> index(new CaIssuerIndex);
+    const uchar *records = data + sizeof(Header);
+    for (quint32 i = 0; i < header.count; ++i) {
+        Record record;
+        memcpy(&record, records + i * sizeof(Record), sizeof(record));
+
+        if (quint64(record.derOffset) + record.derLength > quint64(size)
+                || quint64(record.subjectOffset) + record.subjectLength > quint64(size)
+                || quint64(record.subjectKeyIdOffset) + record.subjectKeyIdLength > quint64(size)) {
+            qWarning() << "Ignoring corrupted CA store snapshot" << file->fileName();
+            return CaIssuerIndexPtr();
+        }
+
+        // The DER is used straight from the mapping, only the index keys
+        // are copied out
+        index->add(QByteArray::fromRawData(reinterpret_cast<const char*>(data + record.derOffset), record.derLength),
+                   QString::fromUtf8(reinterpret_cast<const char*>(data + record.subjectOffset), record.subjectLength),
+                   QByteArray(reinterpret_cast<const char*>(data + record.subjectKeyIdOffset), record.subjectKeyIdLength));
+    }
+    index->setBackingFile(file);
+
+    return index;
+}
+
+void CaStoreSnapshot::save(const QByteArray &stamp, const CaIssuerIndex &index)
+{
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = s_magic;
+    header.version = s_version;
+    memcpy(header.stamp, stamp.constData(), qMin(stamp.size(), int(sizeof(header.stamp))));
+    header.count = index.size();
+
+    QVector<Record> records(index.size());
+    QByteArray blobs;
+    const quint32 blobStart = sizeof(Header) + index.size() * sizeof(Record);
+    for (int i = 0; i < index.size(); ++i) {
+        const QByteArray der = index.der(i);
+        const QByteArray subject = index.subject(i).toUtf8();
+        const QByteArray subjectKeyId = index.subjectKeyId(i);
+
+        Record &record = records[i];
+        record.derOffset = blobStart + blobs.size();
+        record.derLength = der.size();
+        blobs += der;
+        record.subjectOffset = blobStart + blobs.size();
+        record.subjectLength = subject.size();
+        blobs += subject;
+        record.subjectKeyIdOffset = blobStart + blobs.size();
+        record.subjectKeyIdLength = subjectKeyId.size();
+        blobs += subjectKeyId;
+    }
+
+    QDir().mkpath(QFileInfo(snapshotFileName()).absolutePath());
+    QSaveFile file(snapshotFileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write the CA store snapshot" << file.fileName();
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.constData()), records.size() * sizeof(Record));
+    file.write(blobs);
+    if (!file.commit()) {
+        qWarning() << "Unable to write the CA store snapshot" << file.fileName();
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CA_STORE_SNAPSHOT_H
+#define CA_STORE_SNAPSHOT_H
+
+#include <QByteArray>
+#include <QStringList>
+
+#include "ca-issuer-index.h"
+
+/**
+ * Compact binary snapshot of the trust store and its issuer index, kept
+ * in the user cache directory.
+ *
+ * Freshly activated handlers map the snapshot instead of asking
+ * KSslCertificateManager for the CA set and parsing every certificate;
+ * the snapshot is tagged with a stamp of the trust store sources and
+ * ignored as soon as any of them changes.
+ */
+namespace CaStoreSnapshot
+{
+    /**
+     * The files and directories the CA set is loaded from, the same
+     * QSslConfiguration::systemCaCertificates() and readCaCertificates()
+     * read.
+     */
+    QStringList sources();
+
+    /**
+     * Where KDE keeps the CA certificates added by the user.
+     */
+    QString userCaDirectory();
+
+    /**
+     * Hash over the path, size and modification time of every file the
+     * CA set is read from.
+     */
+    QByteArray sourceStamp();
+
+    /**
+     * Maps the snapshot, returns a null pointer if there is none or it
+     * does not match @p stamp.
+     */
+    CaIssuerIndexPtr load(const QByteArray &stamp);
+
+    void save(const QByteArray &stamp, const CaIssuerIndex &index);
+}
+
+#endif // CA_STORE_SNAPSHOT_H
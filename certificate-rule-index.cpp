@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "certificate-rule-index.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+
+// Rules expiring sooner than this are swept from memory by the wheel
+static const qint64 s_sessionRuleLifetimeSecs = 60 * 60;
+// One slot per minute, enough to hold a session rule without wrapping
+static const int s_wheelSlots = 64;
+static const int s_wheelResolutionMSecs = 60 * 1000;
+
+CertificateRuleIndex *CertificateRuleIndex::self()
+{
+    static CertificateRuleIndex index;
+    return &index;
+}
+
+CertificateRuleIndex::CertificateRuleIndex()
+    : m_wheel(s_wheelSlots),
+      m_wheelTick(QDateTime::currentMSecsSinceEpoch() / s_wheelResolutionMSecs)
+{
+    m_wheelTimer.setInterval(s_wheelResolutionMSecs);
+    connect(&m_wheelTimer, SIGNAL(timeout()), SLOT(onWheelTick()));
+}
+
+KSslCertificateRule CertificateRuleIndex::rule(const QSslCertificate &cert, const QString &hostName)
+{
+    const QByteArray ruleKey = key(cert, hostName);
+
+    QHash<QByteArray, KSslCertificateRule>::const_iterator it = m_rules.constFind(ruleKey);
+    if (it != m_rules.constEnd()) {
+        // The manager hands out rules with an invalid expiry when it has
+        // none, those are cached too so that the common case of a
+        // certificate without a rule never goes back to kssld
+        const QDateTime expiry = it->expiryDateTime();
+        if (!expiry.isValid() || expiry > QDateTime::currentDateTime()) {
+            return *it;
+        }
+        // Expired but not swept by the wheel yet
+        m_rules.remove(ruleKey);
+        m_sessionRules.remove(ruleKey);
+    }
+
+    const KSslCertificateRule rule = KSslCertificateManager::self()->rule(cert, hostName);
+    m_rules.insert(ruleKey, rule);
+    return rule;
+}
+
+void CertificateRuleIndex::setRule(const KSslCertificateRule &rule)
+{
+    const QByteArray ruleKey = key(rule.certificate(), rule.hostName());
+    m_rules.insert(ruleKey, rule);
+
+    // Short-lived rules, such as "Current Session only", stay in memory
+    // and never reach the persistent KSsl store
+    const QDateTime expiry = rule.expiryDateTime();
+    if (expiry.isValid() && expiry < QDateTime::currentDateTime().addSecs(s_sessionRuleLifetimeSecs)) {
+        m_sessionRules.insert(ruleKey);
+        scheduleExpiry(ruleKey, expiry);
+    } else {
+        m_sessionRules.remove(ruleKey);
+        KSslCertificateManager::self()->setRule(rule);
+    }
+}
+
+void CertificateRuleIndex::onWheelTick()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / s_wheelResolutionMSecs;
+    const QDateTime currentDateTime = QDateTime::currentDateTime();
+
+    for (; m_wheelTick <= now; ++m_wheelTick) {
+        QSet<QByteArray> &slot = m_wheel[m_wheelTick % s_wheelSlots];
+        QSet<QByteArray>::iterator it = slot.begin();
+        while (it != slot.end()) {
+            const QByteArray &ruleKey = *it;
+            if (!m_sessionRules.contains(ruleKey)) {
+                it = slot.erase(it);
+            } else if (m_rules.value(ruleKey).expiryDateTime() <= currentDateTime) {
+                m_sessionRules.remove(ruleKey);
+                m_rules.remove(ruleKey);
+                it = slot.erase(it);
+            } else {
+                // Due in a later round of the wheel
+                ++it;
+            }
+        }
+    }
+
+    if (m_sessionRules.isEmpty()) {
+        m_wheelTimer.stop();
+    }
+}
+
+QByteArray CertificateRuleIndex::key(const QSslCertificate &cert, const QString &hostName)
+{
+    return cert.digest(QCryptographicHash::Sha256) + hostName.toLower().toUtf8();
+}
+
+void CertificateRuleIndex::scheduleExpiry(const QByteArray &key, const QDateTime &expiry)
+{
+    if (!m_wheelTimer.isActive()) {
+        m_wheelTick = QDateTime::currentMSecsSinceEpoch() / s_wheelResolutionMSecs;
+        m_wheelTimer.start();
+    }
+
+    const qint64 tick = qMax(m_wheelTick,
+            expiry.toMSecsSinceEpoch() / s_wheelResolutionMSecs + 1);
+    m_wheel[tick % s_wheelSlots].insert(key);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CERTIFICATE_RULE_INDEX_H
+#define CERTIFICATE_RULE_INDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include <ksslcertificatemanager.h>
+
+/**
+ * In-memory index in front of KSslCertificateManager's rules, keyed by
+ * certificate fingerprint and hostname.
+ *
+ * Rules, and the absence of a rule, are read from KSslCertificateManager
+ * once per process and then served from memory; rules set through the
+ * index are written through to the manager. Rules changed by other
+ * processes meanwhile are only seen by the next activation.
+ *
+ * Short-lived rules, such as "Current Session only", are only kept in
+ * memory and dropped by a coarse timer wheel once they expire; they are
+ * lost when the handler exits on idle, and the user is asked again.
+ *
+ * Must only be used from the main thread.
+ */
+class CertificateRuleIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static CertificateRuleIndex *self();
+
+    KSslCertificateRule rule(const QSslCertificate &cert, const QString &hostName);
+    void setRule(const KSslCertificateRule &rule);
+
+private Q_SLOTS:
+    void onWheelTick();
+
+private:
+    CertificateRuleIndex();
+    Q_DISABLE_COPY(CertificateRuleIndex)
+
+    static QByteArray key(const QSslCertificate &cert, const QString &hostName);
+    void scheduleExpiry(const QByteArray &key, const QDateTime &expiry);
+
+    QHash<QByteArray, KSslCertificateRule> m_rules;
+    QSet<QByteArray> m_sessionRules;
+    QVector<QSet<QByteArray> > m_wheel;
+    QTimer m_wheelTimer;
+    qint64 m_wheelTick;
+};
+
+#endif // CERTIFICATE_RULE_INDEX_H
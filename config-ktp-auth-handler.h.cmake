@@ -0,0 +1,2 @@
+/* Define if the OpenSSL certificate verifier backend is built */
+#cmakedefine HAVE_OPENSSL 1
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "credentials-cache.h"
+#include "qca-support.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+CredentialsCache *CredentialsCache::self()
+{
+    static CredentialsCache cache;
+    return &cache;
+}
+
+CredentialsCache::CredentialsCache()
+    : m_ttlMSecs(0),
+      m_hits(0),
+      m_misses(0)
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(QStringLiteral("ktp-auth-handlerrc"));
+    const int ttl = config->group(QStringLiteral("SASL")).readEntry(QStringLiteral("CredentialsCacheTTL"), 300);
+    m_ttlMSecs = qMax(ttl, 0) * qint64(1000);
+    m_clock.start();
+}
+
+QString CredentialsCache::key(const QString &accountPath, const QString &mechanism)
+{
+    return accountPath + QLatin1Char(' ') + mechanism;
+}
+
+void CredentialsCache::clear()
+{
+    self()->m_entries.clear();
+}
+
+const CredentialsCache::Entry *CredentialsCache::find(const QString &key)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return 0;
+    }
+
+    if (it->expiry <= m_clock.elapsed()) {
+        m_entries.erase(it);
+        return 0;
+    }
+
+    return &it.value();
+}
+
+bool CredentialsCache::contains(const QString &accountPath, const QString &mechanism)
+{
+    return find(key(accountPath, mechanism)) != 0;
+}
+
+bool CredentialsCache::lookup(const QString &accountPath, const QString &mechanism, QByteArray *data)
+{
+    const Entry *entry = find(key(accountPath, mechanism));
+    if (entry) {
+        *data = entry->data.toByteArray();
+        ++m_hits;
+    } else {
+        ++m_misses;
+    }
+
+    qDebug() << "Credentials cache: hits" << m_hits << "misses" << m_misses
+             << "hit rate" << (100 * m_hits / (m_hits + m_misses)) << "%";
+
+    return entry != 0;
+}
+
+void CredentialsCache::insert(const QString &accountPath, const QString &mechanism, const QByteArray &data)
+{
+    if (m_ttlMSecs == 0) {
+        return;
+    }
+
+    // Secure memory needs QCA to be initialized. The cache may have been
+    // created before QCA and so be destroyed after it, the entries are
+    // dropped with the application object instead.
+    QcaSupport::initialize();
+    static bool clearRegistered = false;
+    if (!clearRegistered) {
+        qAddPostRoutine(clear);
+        clearRegistered = true;
+    }
+
+    Entry entry;
+    entry.data = QCA::SecureArray(data);
+    entry.expiry = m_clock.elapsed() + m_ttlMSecs;
+    m_entries.insert(key(accountPath, mechanism), entry);
+}
+
+void CredentialsCache::invalidate(const QString &accountPath)
+{
+    const QString prefix = accountPath + QLatin1Char(' ');
+    QHash<QString, Entry>::iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        if (it.key().startsWith(prefix)) {
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+quint64 CredentialsCache::hits() const
+{
+    return m_hits;
+}
+
+quint64 CredentialsCache::misses() const
+{
+    return m_misses;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CREDENTIALS_CACHE_H
+#define CREDENTIALS_CACHE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+
+#include <QtCrypto>
+
+/**
+ * Short-lived cache of the data given to StartMechanismWithData, per
+ * account and SASL mechanism, so that reconnecting shortly after a
+ * successful login does not have to ask signond again.
+ *
+ * The data is kept in QCA secure memory, which is locked and zeroed when
+ * freed. QCA is only initialized once a secret is actually inserted, looking
+ * up an empty cache does not need it. The entries are dropped when the
+ * application object is destroyed, before QCA goes away.
+ *
+ * Entries live for the CredentialsCacheTTL seconds of the [SASL] group of
+ * ktp-auth-handlerrc (300 by default, 0 disables the cache), and the
+ * mechanisms drop them as soon as the server refuses them.
+ *
+ * Must only be used from the main thread.
+ */
+class CredentialsCache
+{
+public:
+    static CredentialsCache *self();
+
+    bool contains(const QString &accountPath, const QString &mechanism);
+    bool lookup(const QString &accountPath, const QString &mechanism, QByteArray *data);
+    void insert(const QString &accountPath, const QString &mechanism, const QByteArray &data);
+    void invalidate(const QString &accountPath);
+
+    quint64 hits() const;
+    quint64 misses() const;
+
+private:
+    CredentialsCache();
+    Q_DISABLE_COPY(CredentialsCache)
+
+    struct Entry
+    {
+        QCA::SecureArray data;
+        // in m_clock milliseconds
+        qint64 expiry;
+    };
+
+    static QString key(const QString &accountPath, const QString &mechanism);
+    static void clear();
+    const Entry *find(const QString &key);
+
+    QElapsedTimer m_clock;
+    qint64 m_ttlMSecs;
+    QHash<QString, Entry> m_entries;
+    quint64 m_hits;
+    quint64 m_misses;
+};
+
+#endif // CREDENTIALS_CACHE_H
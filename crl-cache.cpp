@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "crl-cache.h"
+#include "qca-support.h"
+#include "tls-verification-cache.h"
+#include "tls-verifier-backend.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <string.h>
+
+#include <QtCrypto>
+
+/*
+ * Layout, all integers in host byte order:
+ *
+ *   Header
+ *   key[count], sorted, see RevocationIndex::key()
+ */
+
+static const quint32 s_magic = 0x4b545052; // "KTPR"
+static const quint32 s_version = 2;
+static const int s_keySize = 32;
+
+struct Header
+{
+    quint32 magic;
+    quint32 version;
+    char stamp[32];
+    quint32 count;
+    quint32 reserved;
+};
+
+static QString indexFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + QLatin1String("/crl-index");
+}
+
+RevocationIndex::RevocationIndex(const QSharedPointer<QFile> &file, const uchar *records, quint32 count)
+    : m_file(file),
+      m_records(records),
+      m_count(count)
+{
+}
+
+QByteArray RevocationIndex::key(const QByteArray &authorityKeyId, const QString &serialNumber)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(authorityKeyId);
+    hash.addData("\0", 1);
+    hash.addData(serialNumber.toLatin1());
+    return hash.result();
+}
+
+int RevocationIndex::size() const
+{
+    return m_count;
+}
+
+bool RevocationIndex::isRevoked(const QByteArray &authorityKeyId, const QString &serialNumber) const
+{
+    if (authorityKeyId.isEmpty() || m_count == 0) {
+        return false;
+    }
+
+    const QByteArray wanted = key(authorityKeyId, serialNumber);
+
+    quint32 low = 0;
+    quint32 high = m_count;
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        const int cmp = memcmp(m_records + middle * s_keySize, wanted.constData(), s_keySize);
+        if (cmp == 0) {
+            return true;
+        } else if (cmp < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return false;
+}
+
+CrlCache *CrlCache::self()
+{
+    static CrlCache cache;
+    return &cache;
+}
+
+CrlCache::CrlCache()
+    : m_initialized(false),
+      m_generation(0)
+{
+    // Operators drop several files at once, coalesce them
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(1000);
+    connect(&m_refreshTimer, SIGNAL(timeout()), SLOT(refresh()));
+
+    connect(&m_watcher, SIGNAL(fileChanged(QString)), SLOT(onSourceChanged(QString)));
+    connect(&m_watcher, SIGNAL(directoryChanged(QString)), SLOT(onSourceChanged(QString)));
+    connect(&m_buildWatcher, SIGNAL(finished()), SLOT(onBuildFinished()));
+}
+
+QStringList CrlCache::sourceDirectories()
+{
+    return QStandardPaths::locateAll(QStandardPaths::GenericConfigLocation,
+                                     QStringLiteral("ktp-auth-handler/crls"),
+                                     QStandardPaths::LocateDirectory);
+}
+
+RevocationIndexPtr CrlCache::index()
+{
+    if (!m_initialized) {
+        m_initialized = true;
+        refresh();
+    }
+
+    return m_index;
+}
+
+quint64 CrlCache::generation() const
+{
+    return m_generation;
+}
+
+void CrlCache::onSourceChanged(const QString &path)
+{
+    // Files replaced by a rename drop out of the watcher
+    if (!m_watcher.files().contains(path) && QFileInfo(path).isFile()) {
+        m_watcher.addPath(path);
+    }
+
+    m_refreshTimer.start();
+}
+
+void CrlCache::refresh()
+{
+    const QStringList directories = sourceDirectories();
+    watchSources(directories);
+
+    if (directories.isEmpty()) {
+        setIndex(QByteArray(), RevocationIndexPtr());
+        return;
+    }
+
+    const QByteArray stamp = sourceStamp(directories);
+    if (stamp == m_stamp || (m_buildWatcher.isRunning() && stamp == m_buildStamp)) {
+        return;
+    }
+
+    // The index cached on disk only has to be mapped
+    const RevocationIndexPtr index = load(stamp);
+    if (!index.isNull()) {
+        setIndex(stamp, index);
+        return;
+    }
+
+    if (m_buildWatcher.isRunning()) {
+        // Look again once the running build is done
+        m_refreshTimer.start();
+        return;
+    }
+
+    // Parsing large CRLs takes a while, keep the event loop free
+    QcaSupport::initialize();
+    m_buildStamp = stamp;
+    m_buildWatcher.setFuture(QtConcurrent::run(TlsVerifierBackend::pool(),
+                                               &CrlCache::buildAndLoad, directories, stamp));
+}
+
+void CrlCache::onBuildFinished()
+{
+    // Kept even if the build failed, so it is not retried until the
+    // files change again
+    setIndex(m_buildStamp, m_buildWatcher.result());
+}
+
+void CrlCache::watchSources(const QStringList &directories)
+{
+    const QStringList watched = m_watcher.files() + m_watcher.directories();
+    Q_FOREACH (const QString &directory, directories) {
+        if (!watched.contains(directory)) {
+            m_watcher.addPath(directory);
+        }
+
+        const QFileInfoList files = QDir(directory).entryInfoList(QDir::Files, QDir::Name);
+        Q_FOREACH (const QFileInfo &info, files) {
+            if (!watched.contains(info.absoluteFilePath())) {
+                m_watcher.addPath(info.absoluteFilePath());
+            }
+        }
+    }
+}
+
+void CrlCache::setIndex(const QByteArray &stamp, const RevocationIndexPtr &index)
+{
+    m_stamp = stamp;
+    if (index == m_index) {
+        return;
+    }
+
+    // Chains accepted before may have been revoked since
+    TlsVerificationCache::self()->clearAccepted();
+    m_index = index;
+    ++m_generation;
+    if (!m_index.isNull()) {
+        qDebug() << "Using" << m_index->size() << "revoked certificates from the CRL cache";
+    }
+}
+
+QByteArray CrlCache::sourceStamp(const QStringList &directories)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArray::number(s_version));
+
+    Q_FOREACH (const QString &directory, directories) {
+        const QFileInfoList files = QDir(directory).entryInfoList(QDir::Files, QDir::Name);
+        Q_FOREACH (const QFileInfo &info, files) {
+            hash.addData(info.absoluteFilePath().toUtf8());
+            hash.addData(QByteArray::number(info.size()));
+            hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+            hash.addData("\0", 1);
+        }
+    }
+
+    return hash.result();
+}
+
+RevocationIndexPtr CrlCache::load(const QByteArray &stamp)
+{
+    QSharedPointer<QFile> file(new QFile(indexFileName()));
+    if (!file->open(QIODevice::ReadOnly)) {
+        return RevocationIndexPtr();
+    }
+
+    const qint64 size = file->size();
+    if (size < qint64(sizeof(Header))) {
+        return RevocationIndexPtr();
+    }
+
+    const uchar *data = file->map(0, size);
+    if (!data) {
+        qWarning() << "Unable to map the CRL index" << file->fileName();
+        return RevocationIndexPtr();
+    }
+
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != s_magic || header.version != s_version
+            || stamp.size() != int(sizeof(header.stamp))
+            || memcmp(header.stamp, stamp.constData(), sizeof(header.stamp)) != 0) {
+        return RevocationIndexPtr();
+    }
+
+    if (quint64(header.count) * s_keySize != quint64(size - sizeof(Header))) {
+        qWarning() << "Ignoring corrupted CRL index" << file->fileName();
+        return RevocationIndexPtr();
+    }
+
+    return RevocationIndexPtr(new RevocationIndex(file, data + sizeof(Header), header.count));
+}
+
+RevocationIndexPtr CrlCache::buildAndLoad(const QStringList &directories, const QByteArray &stamp)
+{
+    build(directories, stamp);
+    return load(stamp);
+}
+
+void CrlCache::build(const QStringList &directories, const QByteArray &stamp)
+{
+    if (!QCA::isSupported("crl")) {
+        qWarning() << "No QCA plugin supports CRLs, revocation will not be checked";
+        return;
+    }
+
+    QVector<QByteArray> keys;
+    Q_FOREACH (const QString &directory, directories) {
+        const QFileInfoList files = QDir(directory).entryInfoList(QDir::Files, QDir::Name);
+        Q_FOREACH (const QFileInfo &info, files) {
+            QFile file(info.absoluteFilePath());
+            if (!file.open(QIODevice::ReadOnly)) {
+                continue;
+            }
+
+            const QByteArray data = file.readAll();
+            QCA::ConvertResult result;
+            QCA::CRL crl = QCA::CRL::fromDER(data, &result);
+            if (result != QCA::ConvertGood) {
+                crl = QCA::CRL::fromPEM(QString::fromLatin1(data), &result);
+            }
+            if (result != QCA::ConvertGood) {
+                qWarning() << "Ignoring unreadable CRL" << file.fileName();
+                continue;
+            }
+
+            if (crl.nextUpdate().isValid() && crl.nextUpdate() < QDateTime::currentDateTime()) {
+                qWarning() << "CRL" << file.fileName() << "is past its next update";
+            }
+
+            const QByteArray issuerKeyId = crl.issuerKeyId();
+            if (issuerKeyId.isEmpty()) {
+                qWarning() << "Ignoring CRL without an authority key identifier" << file.fileName();
+                continue;
+            }
+
+            Q_FOREACH (const QCA::CRLEntry &entry, crl.revoked()) {
+                keys << RevocationIndex::key(issuerKeyId, entry.serialNumber().toString());
+            }
+        }
+    }
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = s_magic;
+    header.version = s_version;
+    memcpy(header.stamp, stamp.constData(), qMin(stamp.size(), int(sizeof(header.stamp))));
+    header.count = keys.size();
+
+    QDir().mkpath(QFileInfo(indexFileName()).absolutePath());
+    QSaveFile file(indexFileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write the CRL index" << file.fileName();
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    Q_FOREACH (const QByteArray &key, keys) {
+        file.write(key);
+    }
+    if (!file.commit()) {
+        qWarning() << "Unable to write the CRL index" << file.fileName();
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CRL_CACHE_H
+#define CRL_CACHE_H
+
+#include <QByteArray>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTimer>
+
+class QFile;
+
+/**
+ * Sorted, memory-mapped set of revoked certificates, looked up by the
+ * key identifier of their issuer and their serial number in O(log n).
+ *
+ * Both are available to every verifier backend without any parsing of
+ * its own, and RFC 5280 requires the key identifier in CRLs and in all
+ * certificates but self-signed ones.
+ *
+ * Not modified once built, so it can be shared with the validation pool.
+ */
+class RevocationIndex
+{
+public:
+    RevocationIndex(const QSharedPointer<QFile> &file, const uchar *records, quint32 count);
+
+    /**
+     * @p serialNumber is in decimal, as given by QCA::BigInteger::toString().
+     */
+    static QByteArray key(const QByteArray &authorityKeyId, const QString &serialNumber);
+
+    int size() const;
+    bool isRevoked(const QByteArray &authorityKeyId, const QString &serialNumber) const;
+
+private:
+    Q_DISABLE_COPY(RevocationIndex)
+
+    QSharedPointer<QFile> m_file;
+    const uchar *m_records;
+    quint32 m_count;
+};
+
+typedef QSharedPointer<const RevocationIndex> RevocationIndexPtr;
+
+/**
+ * Revocation data provisioned by the operator as CRL files, in DER or
+ * PEM, under ktp-auth-handler/crls in the config directories (e.g.
+ * /etc/xdg/ktp-auth-handler/crls).
+ *
+ * The CRLs are trusted like the CA bundle itself: their signatures are not
+ * checked and no network access is ever made. The directories are
+ * watched; whenever the files change they are parsed in the validation
+ * pool into an index cached on disk, which is then only mapped, and
+ * recently accepted chains are forgotten. Until then the previous index
+ * stays in use. A crls directory created later is only seen by the next
+ * activation.
+ *
+ * Must only be used from the main thread.
+ */
+class CrlCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static CrlCache *self();
+
+    static QStringList sourceDirectories();
+
+    /**
+     * Returns the current index, or a null pointer if no CRL is
+     * provisioned. Only the first call reads the disk.
+     */
+    RevocationIndexPtr index();
+
+    /**
+     * Bumped every time the index is replaced.
+     */
+    quint64 generation() const;
+
+private Q_SLOTS:
+    void onSourceChanged(const QString &path);
+    void refresh();
+    void onBuildFinished();
+
+private:
+    CrlCache();
+    Q_DISABLE_COPY(CrlCache)
+
+    static QByteArray sourceStamp(const QStringList &directories);
+    static RevocationIndexPtr load(const QByteArray &stamp);
+    static void build(const QStringList &directories, const QByteArray &stamp);
+    static RevocationIndexPtr buildAndLoad(const QStringList &directories, const QByteArray &stamp);
+
+    void watchSources(const QStringList &directories);
+    void setIndex(const QByteArray &stamp, const RevocationIndexPtr &index);
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_refreshTimer;
+    QFutureWatcher<RevocationIndexPtr> m_buildWatcher;
+    QByteArray m_buildStamp;
+    bool m_initialized;
+    QByteArray m_stamp;
+    RevocationIndexPtr m_index;
+    quint64 m_generation;
+};
+
+#endif // CRL_CACHE_H
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "intermediate-certificate-cache.h"
+#include "qca-support.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+static const int s_maxEntries = 256;
+// Longest chain we are willing to complete from the cache
+static const int s_maxDepth = 8;
+static const quint32 s_fileMagic = 0x4b545049; // "KTPI"
+static const quint32 s_fileVersion = 1;
+// Chains are validated in bursts, write what they taught us once
+static const int s_saveDelayMSecs = 30 * 1000;
+
+static QString cacheFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + QLatin1String("/intermediate-certificates");
+}
+
+static QByteArray fingerprint(const QByteArray &der)
+{
+    return QCryptographicHash::hash(der, QCryptographicHash::Sha256);
+}
+
+IntermediateCertificateCache *IntermediateCertificateCache::self()
+{
+    static IntermediateCertificateCache cache;
+    return &cache;
+}
+
+IntermediateCertificateCache::IntermediateCertificateCache()
+    : m_loaded(false),
+      m_useCounter(0),
+      m_dirty(false)
+{
+    // Created after QCA, so the certificates are freed before it goes away
+    QcaSupport::initialize();
+
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(s_saveDelayMSecs);
+    connect(&m_saveTimer, SIGNAL(timeout()), SLOT(save()));
+
+    qAddPostRoutine(saveOnExit);
+}
+
+QList<QCA::Certificate> IntermediateCertificateCache::issuersFor(const QCA::CertificateChain &chain)
+{
+    QMutexLocker locker(&m_mutex);
+    load();
+
+    QList<QCA::Certificate> issuers;
+    if (chain.isEmpty() || m_entries.isEmpty()) {
+        return issuers;
+    }
+
+    QCA::Certificate current = chain.last();
+    while (!current.isSelfSigned() && issuers.size() < s_maxDepth) {
+        Entry *issuer = findIssuer(current);
+        if (!issuer || chain.contains(issuer->certificate) || issuers.contains(issuer->certificate)) {
+            break;
+        }
+
+        issuer->lastUsed = ++m_useCounter;
+        issuers << issuer->certificate;
+        current = issuer->certificate;
+    }
+
+    return issuers;
+}
+
+void IntermediateCertificateCache::learn(const QCA::CertificateChain &chain)
+{
+    if (chain.isEmpty()) {
+        return;
+    }
+
+    // Servers sometimes send unrelated certificates along, only follow
+    // the path that was actually validated
+    QList<QCA::Certificate> path;
+    QCA::Certificate current = chain.first();
+    while (!current.isSelfSigned() && path.size() < s_maxDepth) {
+        QCA::Certificate issuer;
+        Q_FOREACH (const QCA::Certificate &cert, chain) {
+            if (cert != current && !path.contains(cert) && cert.isIssuerOf(current)) {
+                issuer = cert;
+                break;
+            }
+        }
+        // Roots belong in the trust store, not here
+        if (issuer.isNull() || !issuer.isCA() || issuer.isSelfSigned()) {
+            break;
+        }
+
+        path << issuer;
+        current = issuer;
+    }
+
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    load();
+
+    bool changed = false;
+    Q_FOREACH (const QCA::Certificate &cert, path) {
+        changed |= insert(cert);
+    }
+
+    if (changed) {
+        evict();
+        if (!m_dirty) {
+            m_dirty = true;
+            QMetaObject::invokeMethod(&m_saveTimer, "start", Qt::QueuedConnection);
+        }
+    }
+}
+
+bool IntermediateCertificateCache::contains(const QByteArray &der)
+{
+    QMutexLocker locker(&m_mutex);
+    load();
+
+    return m_entries.contains(fingerprint(der));
+}
+
+void IntermediateCertificateCache::load()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QFile file(cacheFileName());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (magic != s_fileMagic || version != s_fileVersion) {
+        qWarning() << "Ignoring intermediate certificate cache with unknown format" << file.fileName();
+        return;
+    }
+
+    QList<QByteArray> certificates;
+    stream >> certificates;
+    Q_FOREACH (const QByteArray &der, certificates) {
+        insert(QCA::Certificate::fromDER(der));
+    }
+
+    qDebug() << "Loaded" << m_entries.size() << "cached intermediate certificates";
+}
+
+void IntermediateCertificateCache::saveOnExit()
+{
+    IntermediateCertificateCache *cache = self();
+    cache->save();
+
+    QMutexLocker locker(&cache->m_mutex);
+    cache->m_entries.clear();
+    cache->m_bySubject.clear();
+    cache->m_bySubjectKeyId.clear();
+}
+
+void IntermediateCertificateCache::save()
+{
+    QList<QByteArray> certificates;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_dirty) {
+            return;
+        }
+        m_dirty = false;
+
+        Q_FOREACH (const Entry &entry, m_entries) {
+            certificates << entry.certificate.toDER();
+        }
+    }
+
+    // Validations go on while the file is written
+    QDir().mkpath(QFileInfo(cacheFileName()).absolutePath());
+
+    QSaveFile file(cacheFileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write the intermediate certificate cache" << file.fileName();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << s_fileMagic << s_fileVersion << certificates;
+    file.commit();
+}
+
+bool IntermediateCertificateCache::insert(const QCA::Certificate &cert)
+{
+    if (cert.isNull()) {
+        return false;
+    }
+
+    const QByteArray key = fingerprint(cert.toDER());
+    if (m_entries.contains(key)) {
+        m_entries[key].lastUsed = ++m_useCounter;
+        return false;
+    }
+
+    Entry entry;
+    entry.certificate = cert;
+    entry.subject = cert.subjectInfoOrdered().toString();
+    entry.subjectKeyId = cert.subjectKeyId();
+    entry.lastUsed = ++m_useCounter;
+    m_entries.insert(key, entry);
+
+    m_bySubject.insert(entry.subject, key);
+    if (!entry.subjectKeyId.isEmpty()) {
+        m_bySubjectKeyId.insert(entry.subjectKeyId, key);
+    }
+
+    return true;
+}
+
+void IntermediateCertificateCache::evict()
+{
+    while (m_entries.size() > s_maxEntries) {
+        QHash<QByteArray, Entry>::iterator oldest = m_entries.begin();
+        for (QHash<QByteArray, Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->lastUsed < oldest->lastUsed) {
+                oldest = it;
+            }
+        }
+
+        m_bySubject.remove(oldest->subject, oldest.key());
+        if (m_bySubjectKeyId.value(oldest->subjectKeyId) == oldest.key()) {
+            m_bySubjectKeyId.remove(oldest->subjectKeyId);
+        }
+        m_entries.erase(oldest);
+    }
+}
+
+IntermediateCertificateCache::Entry *IntermediateCertificateCache::findIssuer(const QCA::Certificate &cert)
+{
+    // The authority key identifier is exact, the issuer name is a fallback
+    // for certificates that do not carry one
+    const QByteArray authorityKeyId = cert.issuerKeyId();
+    if (!authorityKeyId.isEmpty()) {
+        const QByteArray key = m_bySubjectKeyId.value(authorityKeyId);
+        if (!key.isEmpty()) {
+            return &m_entries[key];
+        }
+    }
+
+    const QString issuer = cert.issuerInfoOrdered().toString();
+    Q_FOREACH (const QByteArray &key, m_bySubject.values(issuer)) {
+        Entry &entry = m_entries[key];
+        if (authorityKeyId.isEmpty() || entry.subjectKeyId.isEmpty()
+                || entry.subjectKeyId == authorityKeyId) {
+            return &entry;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef INTERMEDIATE_CERTIFICATE_CACHE_H
+#define INTERMEDIATE_CERTIFICATE_CACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <QtCrypto>
+
+/**
+ * Persistent, size-bounded cache of the intermediate CA certificates seen
+ * in chains that validated successfully.
+ *
+ * Many servers only send their leaf certificate; the cache lets such
+ * chains be completed locally, looking issuers up by subject key
+ * identifier or subject name, instead of asking the user about an
+ * untrusted certificate.
+ *
+ * Thread-safe, it is used from the validation pool, but self() must
+ * first be called from the main thread. New intermediates are written to
+ * disk in batches, and on exit.
+ */
+class IntermediateCertificateCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static IntermediateCertificateCache *self();
+
+    /**
+     * Returns the cached intermediates that extend @p chain towards a
+     * root, in issuing order, or an empty list if none are known.
+     */
+    QList<QCA::Certificate> issuersFor(const QCA::CertificateChain &chain);
+
+    /**
+     * Remembers the intermediates on the path from the leaf of @p chain
+     * towards its root. @p chain must have been validated successfully.
+     */
+    void learn(const QCA::CertificateChain &chain);
+
+    /**
+     * Returns whether the certificate with DER @p der is cached.
+     */
+    bool contains(const QByteArray &der);
+
+private Q_SLOTS:
+    void save();
+
+private:
+    IntermediateCertificateCache();
+    Q_DISABLE_COPY(IntermediateCertificateCache)
+
+    struct Entry
+    {
+        QCA::Certificate certificate;
+        QString subject;
+        QByteArray subjectKeyId;
+        quint64 lastUsed;
+    };
+
+    static void saveOnExit();
+    void load();
+    bool insert(const QCA::Certificate &cert);
+    void evict();
+    Entry *findIssuer(const QCA::Certificate &cert);
+
+    QMutex m_mutex;
+    bool m_loaded;
+    quint64 m_useCounter;
+    bool m_dirty;
+    QTimer m_saveTimer;
+    // keyed by SHA-256 of the DER
+    QHash<QByteArray, Entry> m_entries;
+    QMultiHash<QString, QByteArray> m_bySubject;
+    QHash<QByteArray, QByteArray> m_bySubjectKeyId;
+};
+
+#endif // INTERMEDIATE_CERTIFICATE_CACHE_H
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "openssl-verifier-backend.h"
+#include "intermediate-certificate-cache.h"
+#include "tls-timings.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+#include <openssl/bn.h>
+#include <openssl/x509_vfy.h>
+#include <openssl/x509v3.h>
+
+static X509 *fromDer(const QByteArray &der)
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(der.constData());
+    return d2i_X509(0, &data, der.size());
+}
+
+// Same mapping as the QCA OpenSSL plugin, so rules and prompts behave
+// the same whatever the backend
+static QCA::Validity toValidity(int error)
+{
+    switch (error) {
+        case X509_V_OK:
+            return QCA::ValidityGood;
+        case X509_V_ERR_CERT_REJECTED:
+            return QCA::ErrorRejected;
+        case X509_V_ERR_CERT_UNTRUSTED:
+            return QCA::ErrorUntrusted;
+        case X509_V_ERR_CERT_SIGNATURE_FAILURE:
+        case X509_V_ERR_CRL_SIGNATURE_FAILURE:
+        case X509_V_ERR_UNABLE_TO_DECRYPT_CERT_SIGNATURE:
+        case X509_V_ERR_UNABLE_TO_DECODE_ISSUER_PUBLIC_KEY:
+            return QCA::ErrorSignatureFailed;
+        case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT:
+        case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY:
+        case X509_V_ERR_UNABLE_TO_VERIFY_LEAF_SIGNATURE:
+        case X509_V_ERR_INVALID_CA:
+            return QCA::ErrorInvalidCA;
+        case X509_V_ERR_DEPTH_ZERO_SELF_SIGNED_CERT:
+        case X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN:
+            return QCA::ErrorSelfSigned;
+        case X509_V_ERR_INVALID_PURPOSE:
+            return QCA::ErrorInvalidPurpose;
+        case X509_V_ERR_CERT_REVOKED:
+            return QCA::ErrorRevoked;
+        case X509_V_ERR_PATH_LENGTH_EXCEEDED:
+            return QCA::ErrorPathLengthExceeded;
+        case X509_V_ERR_CERT_NOT_YET_VALID:
+        case X509_V_ERR_CERT_HAS_EXPIRED:
+        case X509_V_ERR_ERROR_IN_CERT_NOT_BEFORE_FIELD:
+        case X509_V_ERR_ERROR_IN_CERT_NOT_AFTER_FIELD:
+            return QCA::ErrorExpired;
+        default:
+            return QCA::ErrorValidityUnknown;
+    }
+}
+
+static bool isRevoked(const RevocationIndexPtr &revocations, X509 *cert)
+{
+    const ASN1_OCTET_STRING *keyId = X509_get0_authority_key_id(cert);
+    if (!keyId) {
+        return false;
+    }
+
+    // Decimal like QCA::BigInteger::toString(), which the CRLs are indexed with
+    BIGNUM *serial = ASN1_INTEGER_to_BN(X509_get0_serialNumber(cert), 0);
+    char *decimal = serial ? BN_bn2dec(serial) : 0;
+    BN_free(serial);
+    if (!decimal) {
+        return false;
+    }
+
+    const bool revoked = revocations->isRevoked(
+            QByteArray(reinterpret_cast<const char *>(ASN1_STRING_get0_data(keyId)), ASN1_STRING_length(keyId)),
+            QString::fromLatin1(decimal));
+    OPENSSL_free(decimal);
+    return revoked;
+}
+
+static int verify(X509_STORE *store, X509 *leaf, const QList<X509*> &intermediates)
+{
+    STACK_OF(X509) *untrusted = sk_X509_new_null();
+    Q_FOREACH (X509 *cert, intermediates) {
+        sk_X509_push(untrusted, cert);
+    }
+
+    int error = X509_V_ERR_UNSPECIFIED;
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    if (ctx && X509_STORE_CTX_init(ctx, store, leaf, untrusted)) {
+        error = X509_verify_cert(ctx) == 1 ? X509_V_OK : X509_STORE_CTX_get_error(ctx);
+    }
+
+    X509_STORE_CTX_free(ctx);
+    // the certificates themselves are owned by the caller
+    sk_X509_free(untrusted);
+    return error;
+}
+
+OpenSslVerifierBackend::OpenSslVerifierBackend()
+    : m_store(0),
+      m_storeGeneration(0)
+{
+}
+
+OpenSslVerifierBackend::~OpenSslVerifierBackend()
+{
+    X509_STORE_free(m_store);
+}
+
+QString OpenSslVerifierBackend::name() const
+{
+    return QStringLiteral("openssl");
+}
+
+X509_STORE *OpenSslVerifierBackend::acquireStore(const CaIssuerIndexPtr &trusted, quint64 caGeneration)
+{
+    QMutexLocker locker(&m_storeMutex);
+
+    if (!m_store || m_storeGeneration != caGeneration) {
+        X509_STORE *store = X509_STORE_new();
+        for (int i = 0; i < trusted->size(); ++i) {
+            X509 *cert = fromDer(trusted->der(i));
+            if (cert) {
+                X509_STORE_add_cert(store, cert);
+                X509_free(cert);
+            }
+        }
+
+        // validations still running keep their own reference
+        X509_STORE_free(m_store);
+        m_store = store;
+        m_storeGeneration = caGeneration;
+        qDebug() << "Loaded" << trusted->size() << "CA certificates into the OpenSSL store";
+    }
+
+    X509_STORE_up_ref(m_store);
+    return m_store;
+}
+
+TlsChainValidation OpenSslVerifierBackend::validate(const TlsCertificateList &certificates,
+                                                    const CaIssuerIndexPtr &trusted,
+                                                    quint64 caGeneration,
+                                                    const RevocationIndexPtr &revocations)
+{
+    TlsChainValidation result;
+    QElapsedTimer timer;
+
+    timer.start();
+    QList<X509*> chain;
+    Q_FOREACH (const TlsCertificate &cert, certificates) {
+        X509 *x509 = fromDer(cert.der());
+        if (!x509) {
+            break;
+        }
+        chain << x509;
+    }
+    result.parseUSecs = TlsTimings::elapsedUSecs(timer);
+
+    if (chain.size() != certificates.size()) {
+        Q_FOREACH (X509 *cert, chain) {
+            X509_free(cert);
+        }
+        result.validity = QCA::ErrorValidityUnknown;
+        result.validateUSecs = 0;
+        result.revocationUSecs = 0;
+        return result;
+    }
+
+    timer.start();
+    X509_STORE *store = acquireStore(trusted, caGeneration);
+    QList<X509*> intermediates = chain.mid(1);
+    int error = verify(store, chain.first(), intermediates);
+
+    // Servers often only send their leaf, try to complete the chain with
+    // intermediates learned from earlier connections before giving up.
+    // Looking them up needs the QCA certificates, but only on this path.
+    QList<X509*> completion;
+    bool completed = false;
+    if (error == X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY ||
+        error == X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT ||
+        error == X509_V_ERR_UNABLE_TO_VERIFY_LEAF_SIGNATURE) {
+        QCA::CertificateChain qcaChain;
+        Q_FOREACH (const TlsCertificate &cert, certificates) {
+            qcaChain << cert.qcaCertificate();
+        }
+
+        Q_FOREACH (const QCA::Certificate &issuer, IntermediateCertificateCache::self()->issuersFor(qcaChain)) {
+            X509 *x509 = fromDer(issuer.toDER());
+            if (x509) {
+                completion << x509;
+            }
+        }
+
+        if (!completion.isEmpty() &&
+            verify(store, chain.first(), intermediates + completion) == X509_V_OK) {
+            qDebug() << "Completed certificate chain with" << completion.size() << "cached intermediates";
+            error = X509_V_OK;
+            completed = true;
+        }
+    }
+    X509_STORE_free(store);
+
+    result.validity = toValidity(error);
+    result.validateUSecs = TlsTimings::elapsedUSecs(timer);
+
+    timer.start();
+    if (!revocations.isNull()) {
+        Q_FOREACH (X509 *cert, completed ? chain + completion : chain) {
+            if (isRevoked(revocations, cert)) {
+                qWarning() << "Certificate chain holds a revoked certificate";
+                result.validity = QCA::ErrorRevoked;
+                break;
+            }
+        }
+    }
+    result.revocationUSecs = TlsTimings::elapsedUSecs(timer);
+
+    // Checked after the revocations, so that revoked intermediates are
+    // not offered to later chains. Only parse the chain with QCA when it
+    // brings intermediates the cache does not know yet.
+    if (result.validity == QCA::ValidityGood) {
+        IntermediateCertificateCache *cache = IntermediateCertificateCache::self();
+        bool unknownIntermediate = false;
+        for (int i = 1; i < chain.size() && !unknownIntermediate; ++i) {
+            X509 *cert = chain.at(i);
+            const bool isRoot = X509_check_issued(cert, cert) == X509_V_OK;
+            unknownIntermediate = X509_check_ca(cert) && !isRoot && !cache->contains(certificates.at(i).der());
+        }
+
+        if (unknownIntermediate) {
+            QCA::CertificateChain qcaChain;
+            Q_FOREACH (const TlsCertificate &cert, certificates) {
+                qcaChain << cert.qcaCertificate();
+            }
+            cache->learn(qcaChain);
+        }
+    }
+
+    Q_FOREACH (X509 *cert, chain + completion) {
+        X509_free(cert);
+    }
+
+    return result;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef OPENSSL_VERIFIER_BACKEND_H
+#define OPENSSL_VERIFIER_BACKEND_H
+
+#include <QMutex>
+
+#include "tls-verifier-backend.h"
+
+#include <openssl/x509.h>
+
+/**
+ * Validates chains straight from their DER with OpenSSL, without going
+ * through QCA::Certificate.
+ *
+ * The trusted CAs are loaded into an X509_STORE once per CA store
+ * generation and shared by all validations.
+ */
+class OpenSslVerifierBackend : public TlsVerifierBackend
+{
+public:
+    OpenSslVerifierBackend();
+    ~OpenSslVerifierBackend() override;
+
+    QString name() const override;
+    TlsChainValidation validate(const TlsCertificateList &certificates,
+                                const CaIssuerIndexPtr &trusted,
+                                quint64 caGeneration,
+                                const RevocationIndexPtr &revocations) override;
+
+private:
+    Q_DISABLE_COPY(OpenSslVerifierBackend)
+
+    /**
+     * Returns a reference to the store for @p caGeneration, rebuilding it
+     * from @p trusted first if needed. Release it with X509_STORE_free().
+     */
+    X509_STORE *acquireStore(const CaIssuerIndexPtr &trusted, quint64 caGeneration);
+
+    QMutex m_storeMutex;
+    X509_STORE *m_store;
+    quint64 m_storeGeneration;
+};
+
+#endif // OPENSSL_VERIFIER_BACKEND_H
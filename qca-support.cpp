@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "qca-support.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <QtCrypto>
+
+void QcaSupport::initialize()
+{
+    static bool initialized = false;
+    if (!initialized) {
+        QElapsedTimer timer;
+        timer.start();
+        // Function-local so that it is destroyed after any other static
+        // holding QCA objects that was created after it
+        static QCA::Initializer initializer;
+        initialized = true;
+        qDebug() << "QCA initialized in" << timer.nsecsElapsed() / 1000 << "us";
+    }
+}
+
+bool QcaSupport::isCertSupported()
+{
+    static int supported = -1;
+    if (supported == -1) {
+        initialize();
+
+        QElapsedTimer timer;
+        timer.start();
+        supported = QCA::isSupported("cert") ? 1 : 0;
+        qDebug() << "QCA provider scan for X.509 support took" << timer.nsecsElapsed() / 1000 << "us";
+    }
+    return supported == 1;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef QCA_SUPPORT_H
+#define QCA_SUPPORT_H
+
+/**
+ * Process-lifetime QCA setup.
+ *
+ * QCA is only initialized the first time one of these is called, so that
+ * activations which never see a TLS channel do not pay for it, and then
+ * stays initialized until the handler exits.
+ */
+namespace QcaSupport
+{
+    void initialize();
+
+    /**
+     * Whether a provider supporting X.509 certificates is available.
+     * The provider scan only happens on the first call.
+     */
+    bool isCertSupported();
+}
+
+#endif // QCA_SUPPORT_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "qca-verifier-backend.h"
+#include "intermediate-certificate-cache.h"
+#include "tls-timings.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+QString QcaVerifierBackend::name() const
+{
+    return QStringLiteral("qca");
+}
+
+TlsChainValidation QcaVerifierBackend::validate(const TlsCertificateList &certificates,
+                                                const CaIssuerIndexPtr &trusted,
+                                                quint64 caGeneration,
+                                                const RevocationIndexPtr &revocations)
+{
+    Q_UNUSED(caGeneration);
+
+    TlsChainValidation result;
+    QElapsedTimer timer;
+
+    timer.start();
+    QCA::CertificateChain chain;
+    Q_FOREACH (const TlsCertificate &cert, certificates) {
+        chain << cert.qcaCertificate();
+    }
+    result.parseUSecs = TlsTimings::elapsedUSecs(timer);
+
+    timer.start();
+    result.validity = chain.validate(trusted->issuersOf(chain));
+
+    // Servers often only send their leaf, try to complete the chain with
+    // intermediates learned from earlier connections before giving up
+    if (result.validity == QCA::ErrorInvalidCA || result.validity == QCA::ErrorUntrusted) {
+        const QList<QCA::Certificate> issuers = IntermediateCertificateCache::self()->issuersFor(chain);
+        if (!issuers.isEmpty()) {
+            QCA::CertificateChain completed = chain;
+            completed << issuers;
+            if (completed.validate(trusted->issuersOf(completed)) == QCA::ValidityGood) {
+                qDebug() << "Completed certificate chain with" << issuers.size() << "cached intermediates";
+                chain = completed;
+                result.validity = QCA::ValidityGood;
+            }
+        }
+    }
+
+    result.validateUSecs = TlsTimings::elapsedUSecs(timer);
+
+    timer.start();
+    if (!revocations.isNull()) {
+        Q_FOREACH (const QCA::Certificate &cert, chain) {
+            if (revocations->isRevoked(cert.issuerKeyId(), cert.serialNumber().toString())) {
+                qWarning() << "Certificate chain holds a revoked certificate:" << cert.commonName();
+                result.validity = QCA::ErrorRevoked;
+                break;
+            }
+        }
+    }
+    result.revocationUSecs = TlsTimings::elapsedUSecs(timer);
+
+    // Revoked intermediates must not be offered to later chains
+    if (result.validity == QCA::ValidityGood) {
+        IntermediateCertificateCache::self()->learn(chain);
+    }
+
+    return result;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef QCA_VERIFIER_BACKEND_H
+#define QCA_VERIFIER_BACKEND_H
+
+#include "tls-verifier-backend.h"
+
+/**
+ * Validates chains with QCA against the CAs the issuer index picks for
+ * them, completing chains with learned intermediates when needed.
+ */
+class QcaVerifierBackend : public TlsVerifierBackend
+{
+public:
+    QString name() const override;
+    TlsChainValidation validate(const TlsCertificateList &certificates,
+                                const CaIssuerIndexPtr &trusted,
+                                quint64 caGeneration,
+                                const RevocationIndexPtr &revocations) override;
+};
+
+#endif // QCA_VERIFIER_BACKEND_H
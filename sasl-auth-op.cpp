@@ -19,31 +19,64 @@
  */
 
 #include "sasl-auth-op.h"
-
-#include "x-telepathy-password-auth-operation.h"
-#include "x-telepathy-sso-google-operation.h"
+#include "account-storage-cache.h"
+#include "credentials-cache.h"
 
 #include <QtCore/QScopedPointer>
 
 #include <TelepathyQt/PendingVariantMap>
 
 #include <QDebug>
+#include <KConfigGroup>
 #include <KLocalizedString>
+#include <KSharedConfig>
+
+#include <KAccounts/core.h>
+#include <KAccounts/getcredentialsjob.h>
+
+#include <Accounts/Account>
+#include <Accounts/Manager>
+
+#include <algorithm>
 
 SaslAuthOp::SaslAuthOp(const Tp::AccountPtr &account,
         const Tp::ChannelPtr &channel)
     : Tp::PendingOperation(channel),
       m_account(account),
       m_channel(channel),
-      m_saslIface(channel->interface<Tp::Client::ChannelInterfaceSASLAuthenticationInterface>())
+      m_saslIface(channel->interface<Tp::Client::ChannelInterfaceSASLAuthenticationInterface>()),
+      m_accountStorageId(0),
+      m_accountStorageFetched(false),
+      m_propertiesFetched(false),
+      m_credentialsJob(0),
+      m_credentialsPrefetched(false),
+      m_saslSucceeded(false)
 {
     //Check if the account has any StorageIdentifier, in which case we will
     //prioritize those mechanism related with KDE Accounts integration
-    QScopedPointer<Tp::Client::AccountInterfaceStorageInterface> accountStorageInterface(
-        new Tp::Client::AccountInterfaceStorageInterface(m_account->busName(), m_account->objectPath()));
+    QString storageProvider;
+    if (AccountStorageCache::self()->lookup(m_account->objectPath(), &m_accountStorageId, &storageProvider)) {
+        qDebug() << "Using cached storage identifier" << m_accountStorageId;
+        m_accountStorageFetched = true;
+        prefetchCredentials();
+    } else {
+        QScopedPointer<Tp::Client::AccountInterfaceStorageInterface> accountStorageInterface(
+            new Tp::Client::AccountInterfaceStorageInterface(m_account->busName(), m_account->objectPath()));
 
-    Tp::PendingVariantMap *pendingMap = accountStorageInterface->requestAllProperties();
-    connect(pendingMap, SIGNAL(finished(Tp::PendingOperation*)), SLOT(onGetAccountStorageFetched(Tp::PendingOperation*)));
+        Tp::PendingVariantMap *pendingMap = accountStorageInterface->requestAllProperties();
+        connect(pendingMap, SIGNAL(finished(Tp::PendingOperation*)), SLOT(onGetAccountStorageFetched(Tp::PendingOperation*)));
+    }
+
+    // Mechanisms also finish without an error when the user cancels, only
+    // the channel tells whether they actually authenticated
+    connect(m_saslIface,
+            SIGNAL(SASLStatusChanged(uint,QString,QVariantMap)),
+            SLOT(onSASLStatusChanged(uint,QString,QVariantMap)));
+
+    // The mechanisms don't depend on the storage, ask for both at once
+    connect(m_saslIface->requestAllProperties(),
+            SIGNAL(finished(Tp::PendingOperation*)),
+            SLOT(gotProperties(Tp::PendingOperation*)));
 }
 
 SaslAuthOp::~SaslAuthOp()
@@ -52,58 +85,97 @@ SaslAuthOp::~SaslAuthOp()
 
 void SaslAuthOp::gotProperties(Tp::PendingOperation *op)
 {
-    if (m_mechanisms.isEmpty()) {
-        if (op->isError()) {
-            qWarning() << "Unable to retrieve available SASL mechanisms";
-            m_channel->requestClose();
-            setFinishedWithError(op->errorName(), op->errorMessage());
-            return;
-        }
-
-        Tp::PendingVariantMap *pvm = qobject_cast<Tp::PendingVariantMap*>(op);
-        m_properties = qdbus_cast<QVariantMap>(pvm->result());
-        m_mechanisms = qdbus_cast<QStringList>(m_properties.value(QLatin1String("AvailableMechanisms")));
-        qDebug() << m_mechanisms;
+    if (op->isError()) {
+        qWarning() << "Unable to retrieve available SASL mechanisms";
+        m_channel->requestClose();
+        setFinishedWithError(op->errorName(), op->errorMessage());
+        return;
     }
 
-    uint status = qdbus_cast<uint>(m_properties.value(QLatin1String("SASLStatus")));
-    QString error = qdbus_cast<QString>(m_properties.value(QLatin1String("SASLError")));
-    QVariantMap errorDetails = qdbus_cast<QVariantMap>(m_properties.value(QLatin1String("SASLErrorDetails")));
-
-    if (m_mechanisms.contains(QLatin1String("X-OAUTH2"))) {
-        qDebug() << "Starting X-OAuth2 auth";
-        m_mechanisms.removeAll(QStringLiteral("X-OAUTH2"));
-        XTelepathySSOGoogleOperation *authop = new XTelepathySSOGoogleOperation(m_account, m_accountStorageId, m_saslIface);
-        connect(authop,
-                SIGNAL(finished(Tp::PendingOperation*)),
-                SLOT(onAuthOperationFinished(Tp::PendingOperation*)));
-
-        authop->onSASLStatusChanged(status, error, errorDetails);
-    } else if (m_mechanisms.contains(QLatin1String("X-TELEPATHY-PASSWORD"))) {
-        qDebug() << "Starting Password auth";
-        m_mechanisms.removeAll(QStringLiteral("X-TELEPATHY-PASSWORD"));
-        Q_EMIT ready(this);
-        XTelepathyPasswordAuthOperation *authop = new XTelepathyPasswordAuthOperation(m_account, m_accountStorageId, m_saslIface, qdbus_cast<bool>(m_properties.value(QLatin1String("CanTryAgain"))));
-        connect(authop,
-                SIGNAL(finished(Tp::PendingOperation*)),
-                SLOT(onAuthOperationFinished(Tp::PendingOperation*)));
+    Tp::PendingVariantMap *pvm = qobject_cast<Tp::PendingVariantMap*>(op);
+    m_properties = qdbus_cast<QVariantMap>(pvm->result());
+    const QStringList available = qdbus_cast<QStringList>(m_properties.value(QLatin1String("AvailableMechanisms")));
+    qDebug() << available;
+    m_mechanisms = SaslMechanismRegistry::self()->resolve(available);
+    m_saslSucceeded = qdbus_cast<uint>(m_properties.value(QLatin1String("SASLStatus"))) == Tp::SASLStatusSucceeded;
+    orderMechanisms();
 
-        authop->onSASLStatusChanged(status, error, errorDetails);
-    } else {
-        qWarning() << "X-TELEPATHY-PASSWORD, X-OAUTH2 are the only supported SASL mechanism and are not available:" << m_mechanisms;
+    m_propertiesFetched = true;
+    if (m_accountStorageFetched) {
+        startNextMechanism();
+    }
+}
+
+void SaslAuthOp::startNextMechanism()
+{
+    if (m_mechanisms.isEmpty()) {
+        const QString message = QStringLiteral("None of the supported SASL mechanisms (%1) are available")
+                .arg(SaslMechanismRegistry::self()->names().join(QStringLiteral(", ")));
+        qWarning() << message << m_properties.value(QLatin1String("AvailableMechanisms"));
         m_channel->requestClose();
-        setFinishedWithError(TP_QT_ERROR_NOT_IMPLEMENTED,
-                QLatin1String("X-TELEPATHY-PASSWORD, X-OAUTH2 are the only supported SASL mechanism and are not available:"));
+        setFinishedWithError(TP_QT_ERROR_NOT_IMPLEMENTED, message);
         return;
     }
+
+    // m_mechanisms is in order of preference
+    const SaslMechanism mechanism = m_mechanisms.takeFirst();
+    m_currentMechanism = mechanism.name;
+    qDebug() << "Starting" << mechanism.name << "auth";
+
+    if (mechanism.capabilities & SaslMechanism::Interactive) {
+        Q_EMIT ready(this);
+    }
+
+    SaslMechanismContext context;
+    context.account = m_account;
+    context.accountStorageId = m_accountStorageId;
+    context.saslIface = m_saslIface;
+    context.canTryAgain = qdbus_cast<bool>(m_properties.value(QLatin1String("CanTryAgain")));
+    context.status = qdbus_cast<uint>(m_properties.value(QLatin1String("SASLStatus")));
+    context.error = qdbus_cast<QString>(m_properties.value(QLatin1String("SASLError")));
+    context.errorDetails = qdbus_cast<QVariantMap>(m_properties.value(QLatin1String("SASLErrorDetails")));
+    context.credentialsJob = 0;
+    context.credentialsJobFinished = false;
+
+    if ((mechanism.capabilities & SaslMechanism::UsesStoredPassword) && m_credentialsJob) {
+        m_credentialsJob->disconnect(this);
+        context.credentialsJob = m_credentialsJob;
+        context.credentialsJobFinished = m_credentialsPrefetched;
+        m_credentialsJob = 0;
+    }
+
+    Tp::PendingOperation *authop = mechanism.factory(context);
+    connect(authop,
+            SIGNAL(finished(Tp::PendingOperation*)),
+            SLOT(onAuthOperationFinished(Tp::PendingOperation*)));
 }
 
 void SaslAuthOp::onAuthOperationFinished(Tp::PendingOperation *op)
 {
+    KConfigGroup history = mechanismHistory();
+    KConfigGroup failures = history.group(QStringLiteral("Failures"));
+    bool historyChanged = false;
+    if (op->isError()) {
+        failures.writeEntry(m_currentMechanism, failures.readEntry(m_currentMechanism, 0) + 1);
+        historyChanged = true;
+    } else if (m_saslSucceeded) {
+        if (history.readEntry(QStringLiteral("LastSucceeded"), QString()) != m_currentMechanism) {
+            history.writeEntry(QStringLiteral("LastSucceeded"), m_currentMechanism);
+            historyChanged = true;
+        }
+        if (failures.hasKey(m_currentMechanism)) {
+            failures.deleteEntry(m_currentMechanism);
+            historyChanged = true;
+        }
+    }
+    if (historyChanged) {
+        history.sync();
+    }
+
     if (op->isError()) {
         if (!m_mechanisms.isEmpty()) {
             // if we have other mechanisms left, try again with different one
-            gotProperties(0);
+            startNextMechanism();
         } else {
             setFinishedWithError(op->errorName(), op->errorMessage());
             m_channel->requestClose();
@@ -114,11 +186,12 @@ void SaslAuthOp::onAuthOperationFinished(Tp::PendingOperation *op)
     }
 }
 
-void SaslAuthOp::setReady()
+void SaslAuthOp::onSASLStatusChanged(uint status, const QString &reason, const QVariantMap &details)
 {
-    connect(m_saslIface->requestAllProperties(),
-            SIGNAL(finished(Tp::PendingOperation*)),
-            SLOT(gotProperties(Tp::PendingOperation*)));
+    Q_UNUSED(reason);
+    Q_UNUSED(details);
+
+    m_saslSucceeded = status == Tp::SASLStatusSucceeded;
 }
 
 void SaslAuthOp::onGetAccountStorageFetched(Tp::PendingOperation* op)
@@ -128,5 +201,71 @@ void SaslAuthOp::onGetAccountStorageFetched(Tp::PendingOperation* op)
     m_accountStorageId = pendingMap->result()["StorageIdentifier"].value<QDBusVariant>().variant().toInt();
     qDebug() << m_accountStorageId;
 
-    setReady();
+    if (!op->isError()) {
+        AccountStorageCache::self()->insert(m_account, m_accountStorageId,
+                                            pendingMap->result()["StorageProvider"].toString());
+    }
+
+    m_accountStorageFetched = true;
+    prefetchCredentials();
+
+    if (m_propertiesFetched) {
+        startNextMechanism();
+    }
+}
+
+KConfigGroup SaslAuthOp::mechanismHistory() const
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(QStringLiteral("ktp-auth-handlerrc"));
+    return config->group(QStringLiteral("SaslMechanisms")).group(m_account->objectPath());
+}
+
+void SaslAuthOp::orderMechanisms()
+{
+    // Without any history, the registry priorities decide
+    const KConfigGroup history = mechanismHistory();
+    const KConfigGroup failures = history.group(QStringLiteral("Failures"));
+    const QString lastSucceeded = history.readEntry(QStringLiteral("LastSucceeded"), QString());
+
+    // What worked last time first, then the ones failing the least
+    std::stable_sort(m_mechanisms.begin(), m_mechanisms.end(),
+                     [&](const SaslMechanism &a, const SaslMechanism &b) {
+        if ((a.name == lastSucceeded) != (b.name == lastSucceeded)) {
+            return a.name == lastSucceeded;
+        }
+        return failures.readEntry(a.name, 0) < failures.readEntry(b.name, 0);
+    });
+}
+
+void SaslAuthOp::prefetchCredentials()
+{
+    if (m_accountStorageId == 0 ||
+        CredentialsCache::self()->contains(m_account->objectPath(), QLatin1String("X-TELEPATHY-PASSWORD"))) {
+        return;
+    }
+
+    // Same conditions as XTelepathyPasswordAuthOperation, which would
+    // prompt instead of using the stored password after a failed login
+    KSharedConfigPtr config = KSharedConfig::openConfig(QStringLiteral("kaccounts-ktprc"));
+    if (config->group(QStringLiteral("lastLoginFailed")).hasKey(m_account->objectPath())) {
+        return;
+    }
+
+    Accounts::Account *account = KAccounts::accountsManager()->account(m_accountStorageId);
+    if (!account || account->value(QStringLiteral("auth/method")).toString() == QLatin1String("oauth2")) {
+        return;
+    }
+
+    // Looked up while the connection manager is still answering, the
+    // password op takes the job over if that mechanism gets picked
+    m_credentialsJob = new GetCredentialsJob(m_accountStorageId, QStringLiteral("password"), QStringLiteral("password"), this);
+    m_credentialsJob->setAutoDelete(false);
+    connect(m_credentialsJob, SIGNAL(finished(KJob*)), SLOT(onCredentialsPrefetched(KJob*)));
+    m_credentialsJob->start();
+}
+
+void SaslAuthOp::onCredentialsPrefetched(KJob *job)
+{
+    Q_UNUSED(job);
+    m_credentialsPrefetched = true;
 }
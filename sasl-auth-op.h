@@ -25,10 +25,17 @@
 #include <TelepathyQt/PendingOperation>
 #include <TelepathyQt/Types>
 
+#include <KConfigGroup>
+
+#include "sasl-mechanism-registry.h"
+
 namespace KTp {
     class WalletInterface;
 }
 
+class GetCredentialsJob;
+class KJob;
+
 class SaslAuthOp : public Tp::PendingOperation
 {
     Q_OBJECT
@@ -45,15 +52,26 @@ private Q_SLOTS:
     void gotProperties(Tp::PendingOperation *op);
     void onAuthOperationFinished(Tp::PendingOperation *op);
     void onGetAccountStorageFetched(Tp::PendingOperation *op);
+    void onCredentialsPrefetched(KJob *job);
+    void onSASLStatusChanged(uint status, const QString &reason, const QVariantMap &details);
 
 private:
-    void setReady();
+    KConfigGroup mechanismHistory() const;
+    void orderMechanisms();
+    void prefetchCredentials();
+    void startNextMechanism();
     KTp::WalletInterface *m_walletInterface;
     Tp::AccountPtr m_account;
     Tp::ChannelPtr m_channel;
     Tp::Client::ChannelInterfaceSASLAuthenticationInterface *m_saslIface;
     int m_accountStorageId;
-    QStringList m_mechanisms;
+    bool m_accountStorageFetched;
+    bool m_propertiesFetched;
+    GetCredentialsJob *m_credentialsJob;
+    bool m_credentialsPrefetched;
+    QList<SaslMechanism> m_mechanisms;
+    QString m_currentMechanism;
+    bool m_saslSucceeded;
     QVariantMap m_properties;
 };
 
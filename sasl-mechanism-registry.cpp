@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sasl-mechanism-registry.h"
+
+#include <algorithm>
+
+static bool higherPriority(const SaslMechanism &a, const SaslMechanism &b)
+{
+    return a.priority > b.priority;
+}
+
+SaslMechanismRegistry *SaslMechanismRegistry::self()
+{
+    static SaslMechanismRegistry registry;
+    return &registry;
+}
+
+SaslMechanismRegistry::SaslMechanismRegistry()
+{
+}
+
+void SaslMechanismRegistry::registerMechanism(const QString &name, int priority,
+                                              SaslMechanism::Capabilities capabilities,
+                                              SaslMechanism::Factory factory)
+{
+    SaslMechanism mechanism;
+    mechanism.name = name;
+    mechanism.priority = priority;
+    mechanism.capabilities = capabilities;
+    mechanism.factory = factory;
+    m_mechanisms.insert(name, mechanism);
+}
+
+QStringList SaslMechanismRegistry::names() const
+{
+    return m_mechanisms.keys();
+}
+
+QList<SaslMechanism> SaslMechanismRegistry::resolve(const QStringList &available) const
+{
+    QList<SaslMechanism> mechanisms;
+    Q_FOREACH (const QString &name, available) {
+        QHash<QString, SaslMechanism>::const_iterator it = m_mechanisms.constFind(name);
+        if (it != m_mechanisms.constEnd()) {
+            mechanisms << it.value();
+        }
+    }
+
+    std::stable_sort(mechanisms.begin(), mechanisms.end(), higherPriority);
+    return mechanisms;
+}
+
+SaslMechanismRegistration::SaslMechanismRegistration(const QString &name, int priority,
+                                                     SaslMechanism::Capabilities capabilities,
+                                                     SaslMechanism::Factory factory)
+{
+    SaslMechanismRegistry::self()->registerMechanism(name, priority, capabilities, factory);
+}
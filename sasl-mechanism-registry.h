@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SASL_MECHANISM_REGISTRY_H
+#define SASL_MECHANISM_REGISTRY_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <TelepathyQt/Channel>
+#include <TelepathyQt/PendingOperation>
+#include <TelepathyQt/Types>
+
+class GetCredentialsJob;
+
+/**
+ * What a mechanism op needs to authenticate on a SASL channel.
+ */
+struct SaslMechanismContext
+{
+    Tp::AccountPtr account;
+    int accountStorageId;
+    Tp::Client::ChannelInterfaceSASLAuthenticationInterface *saslIface;
+    bool canTryAgain;
+
+    // SASL status of the channel when the mechanism is started
+    uint status;
+    QString error;
+    QVariantMap errorDetails;
+
+    // Password lookup started ahead of time, only given to mechanisms
+    // with the UsesStoredPassword capability
+    GetCredentialsJob *credentialsJob;
+    bool credentialsJobFinished;
+};
+
+struct SaslMechanism
+{
+    enum Capability {
+        NoCapabilities = 0x0,
+        // May show UI, HandleChannels must return before it starts
+        Interactive = 0x1,
+        // Authenticates with the password stored for the account
+        UsesStoredPassword = 0x2
+    };
+    Q_DECLARE_FLAGS(Capabilities, Capability)
+
+    /**
+     * Creates the op authenticating with the mechanism and starts it with
+     * the channel status of @p context.
+     */
+    typedef Tp::PendingOperation *(*Factory)(const SaslMechanismContext &context);
+
+    QString name;
+    int priority;
+    Capabilities capabilities;
+    Factory factory;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(SaslMechanism::Capabilities)
+
+/**
+ * The SASL mechanisms the handler can authenticate with, keyed by name.
+ * Every mechanism registers itself, see SaslMechanismRegistration.
+ *
+ * Must only be used from the main thread.
+ */
+class SaslMechanismRegistry
+{
+public:
+    static SaslMechanismRegistry *self();
+
+    void registerMechanism(const QString &name, int priority,
+                           SaslMechanism::Capabilities capabilities,
+                           SaslMechanism::Factory factory);
+
+    QStringList names() const;
+
+    /**
+     * Returns the registered mechanisms among @p available, highest
+     * priority first.
+     */
+    QList<SaslMechanism> resolve(const QStringList &available) const;
+
+private:
+    SaslMechanismRegistry();
+    Q_DISABLE_COPY(SaslMechanismRegistry)
+
+    QHash<QString, SaslMechanism> m_mechanisms;
+};
+
+/**
+ * Registers a mechanism when the handler starts, declared as a static
+ * object next to the op implementing it.
+ */
+class SaslMechanismRegistration
+{
+public:
+    SaslMechanismRegistration(const QString &name, int priority,
+                              SaslMechanism::Capabilities capabilities,
+                              SaslMechanism::Factory factory);
+};
+
+#endif // SASL_MECHANISM_REGISTRY_H
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "spki-pin-store.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QSslCertificate>
+#include <QSslKey>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+static void readPins(const KConfigGroup &group, QHash<QString, QSet<QByteArray> > &pins,
+                     bool lowerCaseKeys)
+{
+    Q_FOREACH (const QString &key, group.keyList()) {
+        QSet<QByteArray> &digests = pins[lowerCaseKeys ? key.toLower() : key];
+        Q_FOREACH (const QString &pin, group.readEntry(key, QStringList())) {
+            const QByteArray digest = QByteArray::fromBase64(pin.trimmed().toLatin1());
+            if (digest.size() == 32) {
+                digests.insert(digest);
+            } else {
+                qWarning() << "Ignoring malformed SPKI pin for" << key;
+            }
+        }
+    }
+}
+
+SpkiPinStore *SpkiPinStore::self()
+{
+    static SpkiPinStore store;
+    return &store;
+}
+
+SpkiPinStore::SpkiPinStore()
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(QStringLiteral("ktp-auth-handlerrc"));
+    const KConfigGroup pins = config->group(QStringLiteral("SpkiPins"));
+    readPins(pins.group(QStringLiteral("Accounts")), m_accountPins, false);
+    readPins(pins.group(QStringLiteral("Hosts")), m_hostPins, true);
+
+    if (!m_accountPins.isEmpty() || !m_hostPins.isEmpty()) {
+        qDebug() << "Loaded SPKI pins for" << m_accountPins.size() << "accounts and"
+                 << m_hostPins.size() << "hosts";
+    }
+}
+
+QByteArray SpkiPinStore::spkiDigest(const QSslCertificate &cert)
+{
+    return QCryptographicHash::hash(cert.publicKey().toDer(), QCryptographicHash::Sha256);
+}
+
+SpkiPinStore::Result SpkiPinStore::check(const QString &accountPath, const QString &hostname,
+                                         const QSslCertificate &leaf) const
+{
+    const QHash<QString, QSet<QByteArray> >::const_iterator account = m_accountPins.constFind(accountPath);
+    const QHash<QString, QSet<QByteArray> >::const_iterator host = m_hostPins.constFind(hostname.toLower());
+    if (account == m_accountPins.constEnd() && host == m_hostPins.constEnd()) {
+        return NotPinned;
+    }
+
+    const QByteArray digest = spkiDigest(leaf);
+    if ((account != m_accountPins.constEnd() && account->contains(digest)) ||
+        (host != m_hostPins.constEnd() && host->contains(digest))) {
+        return Match;
+    }
+
+    return Mismatch;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SPKI_PIN_STORE_H
+#define SPKI_PIN_STORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+class QSslCertificate;
+
+/**
+ * Public keys pinned for accounts or hostnames, read once from the
+ * ktp-auth-handlerrc config file:
+ *
+ * @code
+ * [SpkiPins][Accounts]
+ * /org/freedesktop/Telepathy/Account/gabble/jabber/work0=<base64 SHA-256>,...
+ *
+ * [SpkiPins][Hosts]
+ * chat.example.com=<base64 SHA-256>,...
+ * @endcode
+ *
+ * Each pin is the base64 SHA-256 digest of a DER SubjectPublicKeyInfo.
+ * When pins exist for the account or the hostname, the server leaf must
+ * match one of them; the CA store is not consulted at all.
+ */
+class SpkiPinStore
+{
+public:
+    enum Result {
+        NotPinned,
+        Match,
+        Mismatch
+    };
+
+    static SpkiPinStore *self();
+
+    static QByteArray spkiDigest(const QSslCertificate &cert);
+
+    Result check(const QString &accountPath, const QString &hostname,
+                 const QSslCertificate &leaf) const;
+
+private:
+    SpkiPinStore();
+    Q_DISABLE_COPY(SpkiPinStore)
+
+    QHash<QString, QSet<QByteArray> > m_accountPins;
+    QHash<QString, QSet<QByteArray> > m_hostPins;
+};
+
+#endif // SPKI_PIN_STORE_H
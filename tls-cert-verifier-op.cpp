@@ -19,28 +19,41 @@
  */
 
 #include "tls-cert-verifier-op.h"
+#include "ca-certificate-store.h"
+#include "certificate-rule-index.h"
+#include "crl-cache.h"
+#include "intermediate-certificate-cache.h"
+#include "qca-support.h"
+#include "spki-pin-store.h"
+#include "tls-trust-prompt.h"
+#include "tls-verification-cache.h"
 
 #include <TelepathyQt/PendingVariantMap>
 
-#include <KMessageBox>
 #include <KLocalizedString>
 
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDebug>
 #include <QSslCertificate>
-#include <QSslCipher>
+#include <QtConcurrentRun>
 
 #include <ksslcertificatemanager.h>
-#include <ksslinfodialog.h>
 
 #include <QtCrypto>
 
+QHash<QByteArray, QFuture<TlsChainValidation> > TlsCertVerifierOp::s_pendingValidations;
+
 TlsCertVerifierOp::TlsCertVerifierOp(const Tp::AccountPtr &account,
         const Tp::ConnectionPtr &connection,
         const Tp::ChannelPtr &channel)
     : Tp::PendingOperation(channel),
       m_account(account),
       m_connection(connection),
-      m_channel(channel)
+      m_channel(channel),
+      m_caGeneration(0),
+      m_validationWatcher(0),
+      m_acceptedFromCache(false)
 {
     QDBusObjectPath certificatePath = qdbus_cast<QDBusObjectPath>(channel->immutableProperties().value(
                 TP_QT_IFACE_CHANNEL_TYPE_SERVER_TLS_CONNECTION + QLatin1String(".ServerCertificate")));
@@ -74,7 +87,7 @@ void TlsCertVerifierOp::gotProperties(Tp::PendingOperation *op)
     Q_EMIT ready(this);
 
     Tp::PendingVariantMap *pvm = qobject_cast<Tp::PendingVariantMap*>(op);
-    QVariantMap props = qdbus_cast<QVariantMap>(pvm->result());
+    const QVariantMap props = pvm->result();
     m_certType = qdbus_cast<QString>(props.value(QLatin1String("CertificateType")));
     m_certData = qdbus_cast<CertificateDataList>(props.value(QLatin1String("CertificateChainData")));
 
@@ -82,143 +95,259 @@ void TlsCertVerifierOp::gotProperties(Tp::PendingOperation *op)
     //we also seem to need to check for "x509" and x509.
     if (m_certType.compare(QLatin1String("\"x509\""), Qt::CaseInsensitive) != 0 &&
         m_certType.compare(QLatin1String("x509"), Qt::CaseInsensitive) != 0) {
-        Tp::TLSCertificateRejectionList rejections;
-        m_authTLSCertificateIface->Reject(rejections);
-        m_channel->requestClose();
-        setFinishedWithError(QLatin1String("Cert.Unknown"),
-                             i18n("Invalid certificate type %1", m_certType));
+        reject(QLatin1String("Cert.Unknown"),
+               i18n("Invalid certificate type %1", m_certType));
+        return;
+    }
+
+    if (m_certData.isTruncated()) {
+        reject(QLatin1String("Cert.Invalid"),
+               i18n("The certificate chain sent by the server is too large"));
+        return;
+    }
+
+    if (m_certData.isEmpty()) {
+        reject(QLatin1String("Cert.Invalid"),
+               i18n("The server did not send any certificate"));
+        return;
+    }
+
+    m_timings.start(m_hostname, m_certData.size());
+    m_timings.setBackend(TlsVerifierBackend::self()->name());
+    QElapsedTimer stageTimer;
+
+    // The connection manager retries aggressively, so chains the user
+    // already refused are turned down before doing any QCA work
+    m_cacheKey = TlsVerificationCache::key(m_certData, m_hostname);
+    if (TlsVerificationCache::self()->isRejected(m_cacheKey, CaCertificateStore::self()->generation())) {
+        TlsVerificationCache::self()->recordShortCircuit();
+        reject(QLatin1String("Cert.Untrusted"),
+               i18n("Certificate rejected by the user"));
         return;
     }
 
-    // Initialize QCA module
-    QCA::Initializer initializer;
-
-    if (!QCA::isSupported("cert")) {
-      Tp::TLSCertificateRejectionList rejections;
-      m_authTLSCertificateIface->Reject(rejections);
-      m_channel->requestClose();
-      setFinishedWithError(
-          QLatin1String("Cert.NoPlugin"),
-          i18n("The SSL/TLS support plugin is not available. "
-               "Certificate validation cannot be done."));
+    m_certificates.clear();
+    for (int i = 0; i < m_certData.size(); ++i) {
+        m_certificates << TlsCertificate(m_certData, i);
+    }
+
+    // Servers with a pinned key are decided by the leaf alone
+    stageTimer.start();
+    const SpkiPinStore::Result pin = SpkiPinStore::self()->check(m_account->objectPath(), m_hostname,
+                                                                 m_certificates.first().sslCertificate());
+    m_timings.record(QStringLiteral("pinCheck"), TlsTimings::elapsedUSecs(stageTimer));
+    if (pin == SpkiPinStore::Match) {
+        qDebug() << "Accepting certificate with a pinned public key for" << m_hostname;
+        accept();
+        return;
+    } else if (pin == SpkiPinStore::Mismatch) {
+        reject(QLatin1String("Cert.Untrusted"),
+               i18n("The public key of the server does not match the one pinned for %1", m_hostname));
+        return;
+    }
+
+    stageTimer.start();
+    m_rule = CertificateRuleIndex::self()->rule(m_certificates.first().sslCertificate(), m_hostname);
+    m_timings.record(QStringLiteral("ruleLookup"), TlsTimings::elapsedUSecs(stageTimer));
+    if (m_rule.isRejected()) {
+        TlsVerificationCache::self()->insertRejected(m_cacheKey, CaCertificateStore::self()->generation());
+        TlsVerificationCache::self()->recordShortCircuit();
+        reject(QLatin1String("Cert.Untrusted"),
+               i18n("Certificate rejected by the user"));
+        return;
+    }
+
+    // QCA is set up on the first TLS channel and kept from then on
+    stageTimer.start();
+    const bool certSupported = QcaSupport::isCertSupported();
+    m_timings.record(QStringLiteral("qcaSetup"), TlsTimings::elapsedUSecs(stageTimer));
+    if (!certSupported) {
+      reject(QLatin1String("Cert.NoPlugin"),
+             i18n("The SSL/TLS support plugin is not available. "
+                  "Certificate validation cannot be done."));
       return;
     }
 
-    QCA::CertificateChain chain;
-    Q_FOREACH (const QByteArray &data, m_certData) {
-        chain << QCA::Certificate::fromDER(data);
+    // The validations use it from the pool, but it has to live here
+    IntermediateCertificateCache::self();
+
+    // Reconnecting to a server we recently accepted does not need to
+    // go through parsing and validation again
+    stageTimer.start();
+    const CaIssuerIndexPtr trusted = CaCertificateStore::self()->issuerIndex();
+    m_caGeneration = CaCertificateStore::self()->generation();
+    m_timings.record(QStringLiteral("caStore"), TlsTimings::elapsedUSecs(stageTimer));
+
+    // The accepted chains are forgotten when the CRLs change
+    if (TlsVerificationCache::self()->isAccepted(m_cacheKey, m_caGeneration)) {
+        qDebug() << "Accepting recently verified certificate chain for" << m_hostname;
+        m_acceptedFromCache = true;
+        accept();
+        return;
     }
 
-    if (verifyCertChain(chain)) {
-        m_authTLSCertificateIface->Accept().waitForFinished();
-        setFinished();
+    stageTimer.start();
+    const RevocationIndexPtr revocations = CrlCache::self()->index();
+    m_timings.record(QStringLiteral("crlIndex"), TlsTimings::elapsedUSecs(stageTimer));
+
+    // Parsing and validating the chain can take a while with big CA
+    // bundles, keep the event loop free for the other channels meanwhile.
+    // Channels for the same chain and hostname share a single validation.
+    QFuture<TlsChainValidation> future;
+    // Validations against an older CA store or older CRLs are not joined,
+    // their result would be cached under the current generation
+    m_validationKey = m_cacheKey + QByteArray::number(m_caGeneration) + '/'
+            + QByteArray::number(CrlCache::self()->generation());
+    if (s_pendingValidations.contains(m_validationKey)) {
+        qDebug() << "Joining the pending validation of the certificate chain for" << m_hostname;
+        future = s_pendingValidations.value(m_validationKey);
     } else {
-        Tp::TLSCertificateRejectionList rejections;
-        m_authTLSCertificateIface->Reject(rejections);
-        m_channel->requestClose();
-        setFinishedWithError(QLatin1String("Cert.Untrusted"),
-                             i18n("Certificate rejected by the user"));
+        future = QtConcurrent::run(TlsVerifierBackend::pool(), TlsVerifierBackend::self(),
+                &TlsVerifierBackend::validate, m_certificates, trusted, m_caGeneration, revocations);
+        s_pendingValidations.insert(m_validationKey, future);
     }
+
+    m_validationWatcher = new QFutureWatcher<TlsChainValidation>(this);
+    connect(m_validationWatcher, SIGNAL(finished()), SLOT(onChainValidated()));
+    m_validationWatcher->setFuture(future);
 }
 
-bool TlsCertVerifierOp::verifyCertChain(const QCA::CertificateChain& chain)
+void TlsCertVerifierOp::onChainValidated()
 {
-    const QList<QSslCertificate> primary = QSslCertificate::fromData(chain.primary().toDER(), QSsl::Der);
-    KSslCertificateManager *const cm = KSslCertificateManager::self();
-    KSslCertificateRule rule = cm->rule(primary.first(), m_hostname);
+    const TlsChainValidation result = m_validationWatcher->result();
+    // A later channel may already have started a new validation under the
+    // same key, leave that one alone
+    if (s_pendingValidations.value(m_validationKey) == m_validationWatcher->future()) {
+        s_pendingValidations.remove(m_validationKey);
+    }
+    m_validationWatcher->deleteLater();
+    m_validationWatcher = 0;
 
-    // Find all errors then are not ignored by the rule
-    QList<KSslError> errors;
+    m_timings.record(QStringLiteral("parse"), result.parseUSecs);
+    m_timings.record(QStringLiteral("validate"), result.validateUSecs);
 
-    QCA::Validity validity = chain.validate(CACollection());
-    if (validity != QCA::ValidityGood) {
-        KSslError::Error error = validityToError(validity);
-        if (!rule.ignoredErrors().contains(error)) {
-            errors << KSslError(error);
-        }
-    }
+    m_timings.record(QStringLiteral("revocation"), result.revocationUSecs);
 
     // If all errors are ignored, just accept
+    const QList<KSslError> errors = unignoredErrors(m_rule, result.validity);
     if (errors.isEmpty()) {
-        return true;
+        TlsVerificationCache::self()->insertAccepted(m_cacheKey, m_caGeneration);
+        accept();
+        return;
     }
 
-    QString message = i18n("The server failed the authenticity check (%1).\n\n", m_hostname);
-    Q_FOREACH(const KSslError &error, errors) {
-        message.append(error.errorString());
-        message.append(QLatin1Char('\n'));
+    // Let the user decide without blocking the other channels
+    TlsTrustPrompt *prompt = TlsTrustPrompt::prompt(m_cacheKey, m_channel, m_rule,
+                                                    m_hostname, m_certificates, errors);
+    connect(prompt,
+            SIGNAL(finished(Tp::PendingOperation*)),
+            SLOT(onTrustPromptFinished(Tp::PendingOperation*)));
+}
+
+void TlsCertVerifierOp::onTrustPromptFinished(Tp::PendingOperation *op)
+{
+    if (op->isError()) {
+        TlsVerificationCache::self()->insertRejected(m_cacheKey, m_caGeneration);
+        reject(op->errorName(), op->errorMessage());
+        return;
     }
 
-    int msgResult;
-    do {
-        msgResult = KMessageBox::warningYesNoCancel(0,
-                               message,
-                               i18n("Server Authentication"),
-                               KGuiItem(i18n("&Details"), QLatin1String("dialog-information")), // yes
-                               KGuiItem(i18n("Co&ntinue"), QLatin1String("arrow-right")), // no
-                               KGuiItem(i18n("&Cancel"), QLatin1String("dialog-cancel")));
-        if (msgResult == KMessageBox::Yes) {
-            showSslDialog(chain, errors);
-        } else if (msgResult == KMessageBox::Cancel) {
-            return false; // reject
-        }
-        // Fall through on KMessageBox::No
-    } while (msgResult == KMessageBox::Yes);
-
-    // Save the user's choice to ignore the SSL errors.
-    msgResult = KMessageBox::warningYesNo(
-                            0,
-                            i18n("Would you like to accept this "
-                                 "certificate forever without "
-                                 "being prompted?"),
-                            i18n("Server Authentication"),
-                            KGuiItem(i18n("&Forever"), QLatin1String("flag-green")),
-                            KGuiItem(i18n("&Current Session only"), QLatin1String("chronometer")));
-    QDateTime ruleExpiry = QDateTime::currentDateTime();
-    if (msgResult == KMessageBox::Yes) {
-        // Accept forever ("for a very long time")
-        ruleExpiry = ruleExpiry.addYears(1000);
-    } else {
-        // Accept "for a short time", half an hour.
-        ruleExpiry = ruleExpiry.addSecs(30*60);
+    TlsVerificationCache::self()->insertAccepted(m_cacheKey, m_caGeneration);
+    accept();
+}
+
+void TlsCertVerifierOp::accept()
+{
+    m_acceptTimer.start();
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+            m_authTLSCertificateIface->Accept(), this);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            SLOT(onAcceptFinished(QDBusPendingCallWatcher*)));
+}
+
+void TlsCertVerifierOp::onAcceptFinished(QDBusPendingCallWatcher *watcher)
+{
+    recordAcceptLatency(m_acceptTimer.elapsed());
+    m_timings.record(QStringLiteral("accept"), TlsTimings::elapsedUSecs(m_acceptTimer));
+
+    QDBusPendingReply<> reply = *watcher;
+    watcher->deleteLater();
+
+    if (reply.isError()) {
+        qWarning() << "Unable to accept the TLS certificate:" << reply.error().message();
+        m_channel->requestClose();
+        m_timings.finish(QStringLiteral("error"));
+        setFinishedWithError(reply.error().name(), reply.error().message());
+        return;
     }
 
-    rule.setExpiryDateTime(ruleExpiry);
-    rule.setIgnoredErrors(errors);
-    cm->setRule(rule);
+    m_timings.finish(m_acceptedFromCache ? QStringLiteral("cached") : QStringLiteral("accepted"));
+    setFinished();
+}
 
-    return true;
+void TlsCertVerifierOp::reject(const QString &errorName, const QString &errorMessage)
+{
+    m_rejectErrorName = errorName;
+    m_rejectErrorMessage = errorMessage;
+
+    Tp::TLSCertificateRejectionList rejections;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+            m_authTLSCertificateIface->Reject(rejections), this);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            SLOT(onRejectFinished(QDBusPendingCallWatcher*)));
 }
 
-void TlsCertVerifierOp::showSslDialog(const QCA::CertificateChain &chain, const QList<KSslError> &errors) const
+void TlsCertVerifierOp::onRejectFinished(QDBusPendingCallWatcher *watcher)
 {
-    QString errorStr;
-    Q_FOREACH (const KSslError &error, errors) {
-        errorStr += QString::number(static_cast<int>(error.error())) + QLatin1Char('\t');
-        errorStr += QLatin1Char('\n');
+    QDBusPendingReply<> reply = *watcher;
+    watcher->deleteLater();
+
+    if (reply.isError()) {
+        qWarning() << "Unable to reject the TLS certificate:" << reply.error().message();
     }
-    errorStr.chop(1);
-
-    // No way to tell whether QSsl::TlsV1 or QSsl::TlsV1Ssl3
-    KSslCipher cipher = QSslCipher(QLatin1String("TLS"), QSsl::TlsV1_0);
-    QString sslCipher = cipher.encryptionMethod() + QLatin1Char('\n');
-    sslCipher += cipher.authenticationMethod() + QLatin1Char('\n');
-    sslCipher += cipher.keyExchangeMethod() + QLatin1Char('\n');
-    sslCipher += cipher.digestMethod();
-
-    const QList<QSslCertificate> qchain = chainToList(chain);
-    QPointer<KSslInfoDialog> dialog(new KSslInfoDialog(0));
-    dialog->setSslInfo(qchain,
-                    QString(), // we don't know the IP
-                    m_hostname, // the URL
-                    QLatin1String("TLS"),
-                    sslCipher,
-                    cipher.usedBits(),
-                    cipher.supportedBits(),
-                    KSslInfoDialog::errorsFromString(errorStr));
-
-    dialog->exec();
-    delete dialog;
+
+    m_channel->requestClose();
+    m_timings.finish(QStringLiteral("rejected"));
+    setFinishedWithError(m_rejectErrorName, m_rejectErrorMessage);
+}
+
+void TlsCertVerifierOp::recordAcceptLatency(qint64 msecs)
+{
+    // Upper bounds of the histogram buckets in milliseconds, the last
+    // bucket collects everything slower than that
+    static const qint64 bounds[] = { 1, 5, 10, 50, 100, 500, 1000 };
+    static const int bucketCount = sizeof(bounds) / sizeof(bounds[0]) + 1;
+    static quint64 buckets[bucketCount] = { 0 };
+
+    int bucket = 0;
+    while (bucket < bucketCount - 1 && msecs >= bounds[bucket]) {
+        ++bucket;
+    }
+    ++buckets[bucket];
+
+    QString histogram;
+    for (int i = 0; i < bucketCount; ++i) {
+        histogram += (i < bucketCount - 1 ? QStringLiteral("<%1ms:").arg(bounds[i])
+                                          : QStringLiteral(">=%1ms:").arg(bounds[i - 1]));
+        histogram += QString::number(buckets[i]) + QLatin1Char(' ');
+    }
+    histogram.chop(1);
+
+    qDebug() << "TLS certificate Accept took" << msecs << "ms, histogram:" << histogram;
+}
+
+QList<KSslError> TlsCertVerifierOp::unignoredErrors(const KSslCertificateRule &rule,
+                                                   QCA::Validity validity) const
+{
+    QList<KSslError> errors;
+    if (validity != QCA::ValidityGood) {
+        KSslError::Error error = validityToError(validity);
+        if (!rule.ignoredErrors().contains(error)) {
+            errors << KSslError(error);
+        }
+    }
+
+    return errors;
 }
 
 KSslError::Error TlsCertVerifierOp::validityToError(QCA::Validity validity) const
@@ -251,25 +380,3 @@ KSslError::Error TlsCertVerifierOp::validityToError(QCA::Validity validity) cons
 
     return KSslError::UnknownError;
 }
-
-QCA::CertificateCollection TlsCertVerifierOp::CACollection() const
-{
-    QList<QSslCertificate> certs = KSslCertificateManager::self()->caCertificates();
-    QCA::CertificateCollection collection;
-
-    Q_FOREACH(const QSslCertificate &cert, certs) {
-        collection.addCertificate(QCA::Certificate::fromDER(cert.toDer()));
-    }
-
-    return collection;
-}
-
-QList< QSslCertificate > TlsCertVerifierOp::chainToList(const QCA::CertificateChain& chain) const
-{
-    QList<QSslCertificate> certs;
-    Q_FOREACH(const QCA::Certificate &cert, chain) {
-        certs << QSslCertificate::fromData(cert.toDER(), QSsl::Der);
-    }
-
-    return certs;
-}
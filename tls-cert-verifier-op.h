@@ -31,11 +31,23 @@
 
 // FIXME: Move this to tp-qt4 itself
 #include "types.h"
+#include "ca-issuer-index.h"
+#include "crl-cache.h"
+#include "tls-certificate.h"
+#include "tls-timings.h"
+#include "tls-verifier-backend.h"
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QHash>
 
 #include <QtCrypto>
 #include <ktcpsocket.h>
+#include <ksslcertificatemanager.h>
+
+class QDBusPendingCallWatcher;
 
-class QSslCertificate;
 class TlsCertVerifierOp : public Tp::PendingOperation
 {
     Q_OBJECT
@@ -51,14 +63,21 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void gotProperties(Tp::PendingOperation *op);
+    void onChainValidated();
+    void onTrustPromptFinished(Tp::PendingOperation *op);
+    void onAcceptFinished(QDBusPendingCallWatcher *watcher);
+    void onRejectFinished(QDBusPendingCallWatcher *watcher);
 
 private:
-    bool verifyCertChain(const QCA::CertificateChain &chain);
-    void showSslDialog(const QCA::CertificateChain &chain, const QList<KSslError> &errors) const;
-    KSslError::Error validityToError(QCA::Validity validity) const;
+    static void recordAcceptLatency(qint64 msecs);
 
-    QCA::CertificateCollection CACollection() const;
-    QList<QSslCertificate> chainToList(const QCA::CertificateChain &chain) const;
+    static QHash<QByteArray, QFuture<TlsChainValidation> > s_pendingValidations;
+
+    void accept();
+    void reject(const QString &errorName, const QString &errorMessage);
+
+    QList<KSslError> unignoredErrors(const KSslCertificateRule &rule, QCA::Validity validity) const;
+    KSslError::Error validityToError(QCA::Validity validity) const;
 
     Tp::AccountPtr m_account;
     Tp::ConnectionPtr m_connection;
@@ -68,6 +87,18 @@ private:
     Tp::Client::AuthenticationTLSCertificateInterface *m_authTLSCertificateIface;
     QString m_certType;
     CertificateDataList m_certData;
+    TlsCertificateList m_certificates;
+    KSslCertificateRule m_rule;
+    QByteArray m_cacheKey;
+    // m_cacheKey plus the CA store generation and CRLs, shared by joined validations
+    QByteArray m_validationKey;
+    quint64 m_caGeneration;
+    QFutureWatcher<TlsChainValidation> *m_validationWatcher;
+    QElapsedTimer m_acceptTimer;
+    bool m_acceptedFromCache;
+    TlsTimings m_timings;
+    QString m_rejectErrorName;
+    QString m_rejectErrorMessage;
 };
 
 #endif
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "tls-certificate.h"
+
+#include <QSharedData>
+
+class TlsCertificate::Private : public QSharedData
+{
+public:
+    Private(const QByteArray &der)
+        : der(der),
+          qcaParsed(false),
+          sslParsed(false)
+    {
+    }
+
+    // keeps the buffer der points into alive
+    CertificateDataList chain;
+    QByteArray der;
+
+    mutable QCA::Certificate qca;
+    mutable QSslCertificate ssl;
+    mutable bool qcaParsed;
+    mutable bool sslParsed;
+};
+
+TlsCertificate::TlsCertificate()
+    : d(new Private(QByteArray()))
+{
+}
+
+TlsCertificate::TlsCertificate(const QByteArray &der)
+    : d(new Private(der))
+{
+}
+
+TlsCertificate::TlsCertificate(const CertificateDataList &chain, int index)
+    : d(new Private(QByteArray()))
+{
+    d->chain = chain;
+    d->der = d->chain.at(index);
+}
+
+TlsCertificate::TlsCertificate(const TlsCertificate &other)
+    : d(other.d)
+{
+}
+
+TlsCertificate::~TlsCertificate()
+{
+}
+
+TlsCertificate &TlsCertificate::operator=(const TlsCertificate &other)
+{
+    d = other.d;
+    return *this;
+}
+
+QByteArray TlsCertificate::der() const
+{
+    return d->der;
+}
+
+QCA::Certificate TlsCertificate::qcaCertificate() const
+{
+    if (!d->qcaParsed) {
+        d->qca = QCA::Certificate::fromDER(d->der);
+        d->qcaParsed = true;
+    }
+    return d->qca;
+}
+
+QSslCertificate TlsCertificate::sslCertificate() const
+{
+    if (!d->sslParsed) {
+        d->ssl = QSslCertificate(d->der, QSsl::Der);
+        d->sslParsed = true;
+    }
+    return d->ssl;
+}
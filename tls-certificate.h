@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TLS_CERTIFICATE_H
+#define TLS_CERTIFICATE_H
+
+#include <QByteArray>
+#include <QExplicitlySharedDataPointer>
+#include <QList>
+#include <QSslCertificate>
+
+#include <QtCrypto>
+
+// FIXME: Move this to tp-qt4 itself
+#include "types.h"
+
+/**
+ * Implicitly shared handle over the DER bytes of one certificate, as
+ * received from the connection manager.
+ *
+ * The QCA and QSsl views are both created lazily from those same bytes
+ * and then kept, so a certificate is never converted back and forth
+ * between the two libraries. A handle may be passed between threads, but
+ * must not be used from two threads at the same time.
+ */
+class TlsCertificate
+{
+public:
+    TlsCertificate();
+    explicit TlsCertificate(const QByteArray &der);
+    /**
+     * Refers to certificate @p index of @p chain, sharing its buffer
+     * instead of copying the DER.
+     */
+    TlsCertificate(const CertificateDataList &chain, int index);
+    TlsCertificate(const TlsCertificate &other);
+    ~TlsCertificate();
+    TlsCertificate &operator=(const TlsCertificate &other);
+
+    QByteArray der() const;
+    QCA::Certificate qcaCertificate() const;
+    QSslCertificate sslCertificate() const;
+
+private:
+    class Private;
+    QExplicitlySharedDataPointer<Private> d;
+};
+
+typedef QList<TlsCertificate> TlsCertificateList;
+
+#endif // TLS_CERTIFICATE_H
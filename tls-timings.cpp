@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "tls-timings.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+
+static QString timingsFile()
+{
+    static const QString fileName = QString::fromLocal8Bit(qgetenv("KTP_AUTH_HANDLER_TLS_TIMINGS"));
+    return fileName;
+}
+
+TlsTimings::TlsTimings()
+    : m_chainLength(0)
+{
+}
+
+bool TlsTimings::isEnabled()
+{
+    return !timingsFile().isEmpty();
+}
+
+qint64 TlsTimings::elapsedUSecs(const QElapsedTimer &timer)
+{
+    return timer.nsecsElapsed() / 1000;
+}
+
+void TlsTimings::start(const QString &hostname, int chainLength)
+{
+    m_hostname = hostname;
+    m_chainLength = chainLength;
+    m_backend.clear();
+    m_stages = QJsonObject();
+    m_total.start();
+}
+
+void TlsTimings::setBackend(const QString &backend)
+{
+    m_backend = backend;
+}
+
+void TlsTimings::record(const QString &stage, qint64 usecs)
+{
+    m_stages.insert(stage, usecs);
+}
+
+void TlsTimings::finish(const QString &outcome)
+{
+    if (!isEnabled() || !m_total.isValid()) {
+        return;
+    }
+
+    QJsonObject entry;
+    entry.insert(QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    entry.insert(QStringLiteral("hostname"), m_hostname);
+    entry.insert(QStringLiteral("chainLength"), m_chainLength);
+    entry.insert(QStringLiteral("outcome"), outcome);
+    if (!m_backend.isEmpty()) {
+        entry.insert(QStringLiteral("backend"), m_backend);
+    }
+    entry.insert(QStringLiteral("stagesUSecs"), m_stages);
+    entry.insert(QStringLiteral("totalUSecs"), elapsedUSecs(m_total));
+
+    QFile file(timingsFile());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Unable to write TLS timings to" << file.fileName();
+        return;
+    }
+    file.write(QJsonDocument(entry).toJson(QJsonDocument::Compact));
+    file.write("\n");
+}
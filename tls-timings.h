@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TLS_TIMINGS_H
+#define TLS_TIMINGS_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QString>
+
+/**
+ * Per-channel timings of the TLS verification stages.
+ *
+ * When KTP_AUTH_HANDLER_TLS_TIMINGS names a file, one JSON object per
+ * verified channel is appended to it, holding the duration of every
+ * recorded stage in microseconds, so that regressions can be tracked
+ * across releases on real reconnection workloads.
+ */
+class TlsTimings
+{
+public:
+    TlsTimings();
+
+    static bool isEnabled();
+    static qint64 elapsedUSecs(const QElapsedTimer &timer);
+
+    void start(const QString &hostname, int chainLength);
+    void setBackend(const QString &backend);
+    void record(const QString &stage, qint64 usecs);
+    void finish(const QString &outcome);
+
+private:
+    QElapsedTimer m_total;
+    QJsonObject m_stages;
+    QString m_hostname;
+    QString m_backend;
+    int m_chainLength;
+};
+
+#endif // TLS_TIMINGS_H
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2011 Collabora Ltd. <http://www.collabora.co.uk/>
+ *   @author Andre Moreira Magalhaes <andre.magalhaes@collabora.co.uk>
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "tls-trust-prompt.h"
+#include "certificate-rule-index.h"
+
+#include <KGuiItem>
+#include <KLocalizedString>
+#include <KMessageBox>
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QSslCipher>
+
+#include <ksslinfodialog.h>
+
+QQueue<QPointer<TlsTrustPrompt> > TlsTrustPrompt::s_queue;
+QPointer<TlsTrustPrompt> TlsTrustPrompt::s_active;
+QHash<QByteArray, TlsTrustPrompt*> TlsTrustPrompt::s_pending;
+
+TlsTrustPrompt *TlsTrustPrompt::prompt(const QByteArray &key,
+                                       const Tp::SharedPtr<Tp::RefCounted> &object,
+                                       const KSslCertificateRule &rule,
+                                       const QString &hostname,
+                                       const TlsCertificateList &certificates,
+                                       const QList<KSslError> &errors)
+{
+    TlsTrustPrompt *prompt = s_pending.value(key);
+    if (prompt) {
+        qDebug() << "Joining the pending certificate prompt for" << hostname;
+        return prompt;
+    }
+
+    prompt = new TlsTrustPrompt(key, object, rule, hostname, certificates, errors);
+    s_pending.insert(key, prompt);
+    return prompt;
+}
+
+TlsTrustPrompt::TlsTrustPrompt(const QByteArray &key,
+                               const Tp::SharedPtr<Tp::RefCounted> &object,
+                               const KSslCertificateRule &rule,
+                               const QString &hostname,
+                               const TlsCertificateList &certificates,
+                               const QList<KSslError> &errors)
+    : Tp::PendingOperation(object),
+      m_key(key),
+      m_rule(rule),
+      m_hostname(hostname),
+      m_certificates(certificates),
+      m_errors(errors)
+{
+    s_queue.enqueue(QPointer<TlsTrustPrompt>(this));
+    if (s_active.isNull()) {
+        showNext();
+    }
+}
+
+TlsTrustPrompt::~TlsTrustPrompt()
+{
+}
+
+void TlsTrustPrompt::showNext()
+{
+    while (!s_queue.isEmpty()) {
+        s_active = s_queue.dequeue();
+        if (!s_active.isNull() && !s_active->isFinished()) {
+            s_active->showWarning();
+            return;
+        }
+    }
+    s_active.clear();
+}
+
+void TlsTrustPrompt::showWarning()
+{
+    QString message = i18n("The server failed the authenticity check (%1).\n\n", m_hostname);
+    Q_FOREACH(const KSslError &error, m_errors) {
+        message.append(error.errorString());
+        message.append(QLatin1Char('\n'));
+    }
+
+    QDialog *dialog = createMessageBox(message,
+            KGuiItem(i18n("&Details"), QLatin1String("dialog-information")),
+            KGuiItem(i18n("Co&ntinue"), QLatin1String("arrow-right")),
+            KGuiItem(i18n("&Cancel"), QLatin1String("dialog-cancel")));
+    connect(dialog, SIGNAL(finished(int)), SLOT(onWarningFinished(int)));
+    dialog->show();
+}
+
+void TlsTrustPrompt::onWarningFinished(int result)
+{
+    switch (result) {
+    case QDialogButtonBox::Yes:
+        showDetails();
+        break;
+    case QDialogButtonBox::No:
+        showExpiryQuestion();
+        break;
+    default:
+        // Cancel, or the dialog was closed
+        finish(false);
+        break;
+    }
+}
+
+void TlsTrustPrompt::showDetails()
+{
+    QString errorStr;
+    Q_FOREACH (const KSslError &error, m_errors) {
+        errorStr += QString::number(static_cast<int>(error.error())) + QLatin1Char('\t');
+        errorStr += QLatin1Char('\n');
+    }
+    errorStr.chop(1);
+
+    // No way to tell whether QSsl::TlsV1 or QSsl::TlsV1Ssl3
+    KSslCipher cipher = QSslCipher(QLatin1String("TLS"), QSsl::TlsV1_0);
+    QString sslCipher = cipher.encryptionMethod() + QLatin1Char('\n');
+    sslCipher += cipher.authenticationMethod() + QLatin1Char('\n');
+    sslCipher += cipher.keyExchangeMethod() + QLatin1Char('\n');
+    sslCipher += cipher.digestMethod();
+
+    QList<QSslCertificate> qchain;
+    Q_FOREACH (const TlsCertificate &cert, m_certificates) {
+        qchain << cert.sslCertificate();
+    }
+
+    KSslInfoDialog *dialog = new KSslInfoDialog(0);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setSslInfo(qchain,
+                    QString(), // we don't know the IP
+                    m_hostname, // the URL
+                    QLatin1String("TLS"),
+                    sslCipher,
+                    cipher.usedBits(),
+                    cipher.supportedBits(),
+                    KSslInfoDialog::errorsFromString(errorStr));
+
+    // Go back to the warning once the user is done with the details
+    connect(dialog, SIGNAL(finished(int)), SLOT(showWarning()));
+    dialog->show();
+}
+
+void TlsTrustPrompt::showExpiryQuestion()
+{
+    // Save the user's choice to ignore the SSL errors.
+    QDialog *dialog = createMessageBox(
+            i18n("Would you like to accept this "
+                 "certificate forever without "
+                 "being prompted?"),
+            KGuiItem(i18n("&Forever"), QLatin1String("flag-green")),
+            KGuiItem(i18n("&Current Session only"), QLatin1String("chronometer")));
+    connect(dialog, SIGNAL(finished(int)), SLOT(onExpiryFinished(int)));
+    dialog->show();
+}
+
+void TlsTrustPrompt::onExpiryFinished(int result)
+{
+    QDateTime ruleExpiry = QDateTime::currentDateTime();
+    if (result == QDialogButtonBox::Yes) {
+        // Accept forever ("for a very long time")
+        ruleExpiry = ruleExpiry.addYears(1000);
+    } else {
+        // Accept "for a short time", half an hour.
+        ruleExpiry = ruleExpiry.addSecs(30*60);
+    }
+
+    m_rule.setExpiryDateTime(ruleExpiry);
+    m_rule.setIgnoredErrors(m_errors);
+    CertificateRuleIndex::self()->setRule(m_rule);
+
+    finish(true);
+}
+
+void TlsTrustPrompt::finish(bool accepted)
+{
+    s_pending.remove(m_key);
+
+    if (accepted) {
+        setFinished();
+    } else {
+        setFinishedWithError(QLatin1String("Cert.Untrusted"),
+                             i18n("Certificate rejected by the user"));
+    }
+
+    if (s_active == this) {
+        showNext();
+    }
+}
+
+QDialog *TlsTrustPrompt::createMessageBox(const QString &text,
+                                          const KGuiItem &yes,
+                                          const KGuiItem &no,
+                                          const KGuiItem &cancel)
+{
+    QDialog *dialog = new QDialog;
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowTitle(i18n("Server Authentication"));
+
+    QDialogButtonBox::StandardButtons buttons = QDialogButtonBox::Yes | QDialogButtonBox::No;
+    if (!cancel.text().isEmpty()) {
+        buttons |= QDialogButtonBox::Cancel;
+    }
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(dialog);
+    buttonBox->setStandardButtons(buttons);
+    KGuiItem::assign(buttonBox->button(QDialogButtonBox::Yes), yes);
+    KGuiItem::assign(buttonBox->button(QDialogButtonBox::No), no);
+    if (!cancel.text().isEmpty()) {
+        KGuiItem::assign(buttonBox->button(QDialogButtonBox::Cancel), cancel);
+    }
+
+    // NoExec makes KMessageBox only lay the dialog out; the buttons still
+    // finish it with the QDialogButtonBox::StandardButton that was clicked
+    KMessageBox::createKMessageBox(dialog, buttonBox, QMessageBox::Warning, text,
+                                   QStringList(), QString(), 0,
+                                   KMessageBox::Options(KMessageBox::Notify | KMessageBox::NoExec));
+    return dialog;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2011 Collabora Ltd. <http://www.collabora.co.uk/>
+ *   @author Andre Moreira Magalhaes <andre.magalhaes@collabora.co.uk>
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TLS_TRUST_PROMPT_H
+#define TLS_TRUST_PROMPT_H
+
+#include <TelepathyQt/PendingOperation>
+#include <TelepathyQt/Types>
+
+#include <QHash>
+#include <QPointer>
+#include <QQueue>
+
+#include <ktcpsocket.h>
+#include <ksslcertificatemanager.h>
+
+#include "tls-certificate.h"
+
+class QDialog;
+
+/**
+ * Pending decision of the user about a certificate chain that failed
+ * verification.
+ *
+ * The warning dialogs are shown non-modally, one prompt at a time, so
+ * that no nested event loop is spun while the user makes up their mind.
+ * The operation finishes successfully if the user accepted the chain, in
+ * which case the rule has already been stored, or with an error if the
+ * chain was rejected.
+ */
+class TlsTrustPrompt : public Tp::PendingOperation
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TlsTrustPrompt)
+
+public:
+    /**
+     * Returns the prompt already pending for @p key, or creates a new one,
+     * so that the same chain and hostname are only asked about once no
+     * matter how many channels are waiting for the decision.
+     */
+    static TlsTrustPrompt *prompt(const QByteArray &key,
+                                  const Tp::SharedPtr<Tp::RefCounted> &object,
+                                  const KSslCertificateRule &rule,
+                                  const QString &hostname,
+                                  const TlsCertificateList &certificates,
+                                  const QList<KSslError> &errors);
+    ~TlsTrustPrompt();
+
+private Q_SLOTS:
+    void showWarning();
+    void onWarningFinished(int result);
+    void onExpiryFinished(int result);
+
+private:
+    TlsTrustPrompt(const QByteArray &key,
+                   const Tp::SharedPtr<Tp::RefCounted> &object,
+                   const KSslCertificateRule &rule,
+                   const QString &hostname,
+                   const TlsCertificateList &certificates,
+                   const QList<KSslError> &errors);
+
+    static void showNext();
+
+    void showDetails();
+    void showExpiryQuestion();
+    void finish(bool accepted);
+    QDialog *createMessageBox(const QString &text,
+                              const KGuiItem &yes,
+                              const KGuiItem &no,
+                              const KGuiItem &cancel = KGuiItem());
+
+    static QQueue<QPointer<TlsTrustPrompt> > s_queue;
+    static QPointer<TlsTrustPrompt> s_active;
+    static QHash<QByteArray, TlsTrustPrompt*> s_pending;
+
+    QByteArray m_key;
+    KSslCertificateRule m_rule;
+    QString m_hostname;
+    TlsCertificateList m_certificates;
+    QList<KSslError> m_errors;
+};
+
+#endif // TLS_TRUST_PROMPT_H
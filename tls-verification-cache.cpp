@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "tls-verification-cache.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+
+// Keep the cache small, it only has to cover a burst of reconnections
+static const int s_maxEntries = 64;
+static const qint64 s_ttlMSecs = 10 * 60 * 1000;
+
+TlsVerificationCache *TlsVerificationCache::self()
+{
+    static TlsVerificationCache cache;
+    return &cache;
+}
+
+TlsVerificationCache::TlsVerificationCache()
+    : m_accepted(s_maxEntries),
+      m_rejected(s_maxEntries),
+      m_hits(0),
+      m_misses(0),
+      m_shortCircuits(0)
+{
+    m_clock.start();
+}
+
+QByteArray TlsVerificationCache::key(const CertificateDataList &chain, const QString &hostname)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (int i = 0; i < chain.size(); ++i) {
+        const QByteArray der = chain.at(i);
+        const quint32 size = der.size();
+        hash.addData(reinterpret_cast<const char*>(&size), sizeof(size));
+        hash.addData(der);
+    }
+    hash.addData(hostname.toUtf8());
+
+    return hash.result();
+}
+
+bool TlsVerificationCache::isAccepted(const QByteArray &key, quint64 caGeneration)
+{
+    const bool accepted = isFresh(&m_accepted, key, caGeneration);
+    if (accepted) {
+        ++m_hits;
+    } else {
+        ++m_misses;
+    }
+
+    qDebug() << "TLS verification cache: hits" << m_hits << "misses" << m_misses;
+
+    return accepted;
+}
+
+void TlsVerificationCache::insertAccepted(const QByteArray &key, quint64 caGeneration)
+{
+    m_accepted.insert(key, newEntry(caGeneration));
+    m_rejected.remove(key);
+}
+
+void TlsVerificationCache::clearAccepted()
+{
+    m_accepted.clear();
+}
+
+bool TlsVerificationCache::isRejected(const QByteArray &key, quint64 caGeneration)
+{
+    return isFresh(&m_rejected, key, caGeneration);
+}
+
+void TlsVerificationCache::insertRejected(const QByteArray &key, quint64 caGeneration)
+{
+    m_accepted.remove(key);
+    m_rejected.insert(key, newEntry(caGeneration));
+}
+
+void TlsVerificationCache::recordShortCircuit()
+{
+    ++m_shortCircuits;
+    qDebug() << "TLS verification cache: rejected" << m_shortCircuits << "known bad chains without validation";
+}
+
+TlsVerificationCache::Entry *TlsVerificationCache::newEntry(quint64 caGeneration) const
+{
+    Entry *entry = new Entry;
+    entry->expiry = m_clock.elapsed() + s_ttlMSecs;
+    entry->caGeneration = caGeneration;
+    return entry;
+}
+
+bool TlsVerificationCache::isFresh(QCache<QByteArray, Entry> *cache, const QByteArray &key,
+                                   quint64 caGeneration) const
+{
+    const Entry *entry = cache->object(key);
+    if (!entry) {
+        return false;
+    }
+
+    // Decisions taken against another CA store, or too long ago, have to
+    // be taken again
+    if (entry->expiry <= m_clock.elapsed() || entry->caGeneration != caGeneration) {
+        cache->remove(key);
+        return false;
+    }
+
+    return true;
+}
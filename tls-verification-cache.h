@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TLS_VERIFICATION_CACHE_H
+#define TLS_VERIFICATION_CACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QElapsedTimer>
+#include <QString>
+
+// FIXME: Move this to tp-qt4 itself
+#include "types.h"
+
+/**
+ * Small in-memory record of the decisions taken about certificate chains.
+ *
+ * Chains recently accepted for a given hostname are kept in an LRU with a
+ * fixed TTL, tagged with the CA store generation they were validated
+ * against, so that reconnecting to the same server does not have to parse
+ * and validate the very same chain again.
+ *
+ * Chains the user rejected are kept the same way in a second LRU, so that
+ * the connection manager retrying does not prompt over and over.
+ */
+class TlsVerificationCache
+{
+public:
+    static TlsVerificationCache *self();
+
+    static QByteArray key(const CertificateDataList &chain, const QString &hostname);
+
+    bool isAccepted(const QByteArray &key, quint64 caGeneration);
+    void insertAccepted(const QByteArray &key, quint64 caGeneration);
+    void clearAccepted();
+
+    bool isRejected(const QByteArray &key, quint64 caGeneration);
+    void insertRejected(const QByteArray &key, quint64 caGeneration);
+    void recordShortCircuit();
+
+private:
+    TlsVerificationCache();
+    Q_DISABLE_COPY(TlsVerificationCache)
+
+    struct Entry
+    {
+        // in m_clock milliseconds
+        qint64 expiry;
+        quint64 caGeneration;
+    };
+
+    Entry *newEntry(quint64 caGeneration) const;
+    bool isFresh(QCache<QByteArray, Entry> *cache, const QByteArray &key, quint64 caGeneration) const;
+
+    QElapsedTimer m_clock;
+    QCache<QByteArray, Entry> m_accepted;
+    QCache<QByteArray, Entry> m_rejected;
+    quint64 m_hits;
+    quint64 m_misses;
+    quint64 m_shortCircuits;
+};
+
+#endif // TLS_VERIFICATION_CACHE_H
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "tls-verifier-backend.h"
+#include "qca-verifier-backend.h"
+
+#include "config-ktp-auth-handler.h"
+#ifdef HAVE_OPENSSL
+#include "openssl-verifier-backend.h"
+#endif
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QThread>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+static TlsVerifierBackend *createBackend()
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(QStringLiteral("ktp-auth-handlerrc"));
+    const QString name = config->group(QStringLiteral("TLS"))
+            .readEntry(QStringLiteral("VerifierBackend"), QStringLiteral("qca")).toLower();
+
+    if (name == QLatin1String("openssl")) {
+#ifdef HAVE_OPENSSL
+        return new OpenSslVerifierBackend;
+#else
+        qWarning() << "Built without OpenSSL, verifying certificates with QCA";
+#endif
+    } else if (name != QLatin1String("qca")) {
+        qWarning() << "Unknown certificate verifier backend" << name << ", using QCA";
+    }
+
+    return new QcaVerifierBackend;
+}
+
+TlsVerifierBackend::~TlsVerifierBackend()
+{
+}
+
+TlsVerifierBackend *TlsVerifierBackend::self()
+{
+    static TlsVerifierBackend *backend = createBackend();
+    return backend;
+}
+
+QThreadPool *TlsVerifierBackend::pool()
+{
+    static QThreadPool *pool = 0;
+    if (!pool) {
+        pool = new QThreadPool(QCoreApplication::instance());
+        pool->setMaxThreadCount(QThread::idealThreadCount());
+    }
+    return pool;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 KDE Telepathy Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TLS_VERIFIER_BACKEND_H
+#define TLS_VERIFIER_BACKEND_H
+
+#include <QString>
+#include <QThreadPool>
+
+#include <QtCrypto>
+
+#include "ca-issuer-index.h"
+#include "crl-cache.h"
+#include "tls-certificate.h"
+
+struct TlsChainValidation
+{
+    QCA::Validity validity;
+    qint64 parseUSecs;
+    qint64 validateUSecs;
+    qint64 revocationUSecs;
+};
+
+/**
+ * Validates certificate chains against the trusted CAs.
+ *
+ * The backend is picked once per process from the VerifierBackend key of
+ * the [TLS] group of ktp-auth-handlerrc: "qca" (the default) or, when
+ * built with OpenSSL, "openssl".
+ *
+ * validate() runs in the validation pool and must be thread-safe.
+ */
+class TlsVerifierBackend
+{
+public:
+    virtual ~TlsVerifierBackend();
+
+    static TlsVerifierBackend *self();
+
+    /**
+     * The bounded pool validations and other expensive TLS work run in,
+     * off the main thread.
+     */
+    static QThreadPool *pool();
+
+    virtual QString name() const = 0;
+
+    /**
+     * Validates @p certificates, leaf first, against @p trusted, which is
+     * generation @p caGeneration of the CA store.
+     *
+     * Every link of the chain that was validated, including those added
+     * from the intermediate cache, is looked up in @p revocations unless
+     * it is null.
+     */
+    virtual TlsChainValidation validate(const TlsCertificateList &certificates,
+                                        const CaIssuerIndexPtr &trusted,
+                                        quint64 caGeneration,
+                                        const RevocationIndexPtr &revocations) = 0;
+};
+
+#endif // TLS_VERIFIER_BACKEND_H
@@ -20,7 +20,78 @@
 // FIXME: Move this to tp-qt4 itself
 #include "types.h"
 
+#include <QDBusArgument>
 #include <QDBusMetaType>
+#include <QDebug>
+
+CertificateDataList::CertificateDataList()
+    : m_truncated(false)
+{
+    m_offsets << 0;
+}
+
+int CertificateDataList::size() const
+{
+    return m_offsets.size() - 1;
+}
+
+bool CertificateDataList::isEmpty() const
+{
+    return size() == 0;
+}
+
+bool CertificateDataList::isTruncated() const
+{
+    return m_truncated;
+}
+
+QByteArray CertificateDataList::at(int index) const
+{
+    const int offset = m_offsets.at(index);
+    return QByteArray::fromRawData(m_data.constData() + offset, m_offsets.at(index + 1) - offset);
+}
+
+bool CertificateDataList::append(const QByteArray &der)
+{
+    if (m_truncated || size() >= MaxCertificates || der.size() > MaxCertificateSize ||
+        m_data.size() + der.size() > MaxChainSize) {
+        m_truncated = true;
+        return false;
+    }
+
+    m_data.append(der);
+    m_offsets << m_data.size();
+    return true;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const CertificateDataList &list)
+{
+    argument.beginArray(qMetaTypeId<QByteArray>());
+    for (int i = 0; i < list.size(); ++i) {
+        argument << list.at(i);
+    }
+    argument.endArray();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, CertificateDataList &list)
+{
+    list = CertificateDataList();
+
+    // Each certificate is copied into the list and dropped right away, and
+    // whatever follows the first one over the limits is never read
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        QByteArray der;
+        argument >> der;
+        if (!list.append(der)) {
+            qWarning() << "Certificate chain over the size limits, ignoring the rest of it";
+            break;
+        }
+    }
+    argument.endArray();
+    return argument;
+}
 
 void registerTypes()
 {
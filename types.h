@@ -22,12 +22,58 @@
 #define TYPES_H
 
 #include <QByteArray>
-#include <QList>
 #include <QMetaType>
+#include <QVector>
+
+class QDBusArgument;
+
+/**
+ * The DER certificates of a chain, leaf first, stored back to back in a
+ * single buffer.
+ *
+ * Demarshalling stops as soon as the chain goes over MaxCertificates,
+ * MaxCertificateSize or MaxChainSize, marking the list as truncated, so a
+ * misbehaving connection manager cannot make us hold on to huge chains.
+ */
+class CertificateDataList
+{
+public:
+    enum {
+        MaxCertificates = 16,
+        MaxCertificateSize = 64 * 1024,
+        MaxChainSize = 256 * 1024
+    };
+
+    CertificateDataList();
+
+    int size() const;
+    bool isEmpty() const;
+    bool isTruncated() const;
+
+    /**
+     * Returns the DER of certificate @p index without copying it; the
+     * bytes stay valid for as long as this list is not modified.
+     */
+    QByteArray at(int index) const;
+
+    /**
+     * Appends @p der, unless that would break one of the limits, in which
+     * case the list is marked as truncated and false is returned.
+     */
+    bool append(const QByteArray &der);
+
+private:
+    QByteArray m_data;
+    // start of each certificate in m_data, plus the end of the last one
+    QVector<int> m_offsets;
+    bool m_truncated;
+};
 
-typedef QList<QByteArray> CertificateDataList;
 Q_DECLARE_METATYPE(CertificateDataList)
 
+QDBusArgument &operator<<(QDBusArgument &argument, const CertificateDataList &list);
+const QDBusArgument &operator>>(const QDBusArgument &argument, CertificateDataList &list);
+
 void registerTypes();
 
 #endif
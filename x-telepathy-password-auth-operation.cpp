@@ -22,6 +22,8 @@
 
 #include "x-telepathy-password-auth-operation.h"
 #include "x-telepathy-password-prompt.h"
+#include "credentials-cache.h"
+#include "sasl-mechanism-registry.h"
 
 #include <KAccounts/getcredentialsjob.h>
 #include <KAccounts/core.h>
@@ -37,6 +39,10 @@
 #include <Accounts/AccountService>
 #include <SignOn/Identity>
 
+static const SaslMechanismRegistration s_registration(QStringLiteral("X-TELEPATHY-PASSWORD"), 50,
+                                                      SaslMechanism::Interactive | SaslMechanism::UsesStoredPassword,
+                                                      &XTelepathyPasswordAuthOperation::create);
+
 XTelepathyPasswordAuthOperation::XTelepathyPasswordAuthOperation(
         const Tp::AccountPtr &account,
         int accountStorageId,
@@ -47,7 +53,9 @@ XTelepathyPasswordAuthOperation::XTelepathyPasswordAuthOperation(
     m_saslIface(saslIface),
     m_canTryAgain(canTryAgain),
     m_canFinish(false),
-    m_accountStorageId(accountStorageId)
+    m_accountStorageId(accountStorageId),
+    m_credentialsJob(0),
+    m_credentialsJobFinished(false)
 {
     connect(m_saslIface,
             SIGNAL(SASLStatusChanged(uint,QString,QVariantMap)),
@@ -69,22 +77,24 @@ void XTelepathyPasswordAuthOperation::onSASLStatusChanged(uint status, const QSt
         // if we have non-null id AND if the last attempt didn't fail,
         // proceed with the credentials receieved from the SSO;
         // otherwise prompt the user
-        if (!m_lastLoginFailedConfig.hasKey(m_account->objectPath())) {
+        QByteArray secret;
+        if (m_lastLoginFailedConfig.hasKey(m_account->objectPath())) {
+            promptUser();
+        } else if (CredentialsCache::self()->lookup(m_account->objectPath(), QLatin1String("X-TELEPATHY-PASSWORD"), &secret)) {
+            qDebug() << "Using the recently used password";
+            m_canFinish = true;
+            m_saslIface->StartMechanismWithData(QLatin1String("X-TELEPATHY-PASSWORD"), secret);
+        } else if (m_credentialsJob) {
+            // the lookup was started while the channel was being set up
+            if (m_credentialsJobFinished) {
+                onCredentialsFetched(m_credentialsJob);
+            } else {
+                connect(m_credentialsJob, SIGNAL(finished(KJob*)), SLOT(onCredentialsFetched(KJob*)));
+            }
+        } else {
             GetCredentialsJob *credentialsJob = new GetCredentialsJob(m_accountStorageId, QStringLiteral("password"), QStringLiteral("password"), this);
-            connect(credentialsJob, &GetCredentialsJob::finished, [this](KJob *job){
-                if (job->error()) {
-                    qWarning() << "Credentials job error:" << job->errorText();
-                    qDebug() << "Prompting for password";
-                    promptUser();
-                } else {
-                    m_canFinish = true;
-                    QByteArray secret = qobject_cast<GetCredentialsJob*>(job)->credentialsData().value("Secret").toByteArray();
-                    m_saslIface->StartMechanismWithData(QLatin1String("X-TELEPATHY-PASSWORD"), secret);
-                }
-            });
+            connect(credentialsJob, SIGNAL(finished(KJob*)), SLOT(onCredentialsFetched(KJob*)));
             credentialsJob->start();
-        } else {
-            promptUser();
         }
     } else if (status == Tp::SASLStatusServerSucceeded) {
         qDebug() << "Authentication handshake";
@@ -106,6 +116,7 @@ void XTelepathyPasswordAuthOperation::onSASLStatusChanged(uint status, const QSt
         qDebug() << "Authenticating...";
     } else if (status == Tp::SASLStatusServerFailed) {
         qDebug() << "Error authenticating - reason:" << reason << "- details:" << details;
+        CredentialsCache::self()->invalidate(m_account->objectPath());
 
         if (m_canTryAgain) {
             qDebug() << "Retrying...";
@@ -127,6 +138,45 @@ void XTelepathyPasswordAuthOperation::onSASLStatusChanged(uint status, const QSt
     }
 }
 
+Tp::PendingOperation *XTelepathyPasswordAuthOperation::create(const SaslMechanismContext &context)
+{
+    XTelepathyPasswordAuthOperation *op = new XTelepathyPasswordAuthOperation(context.account,
+            context.accountStorageId, context.saslIface, context.canTryAgain);
+    if (context.credentialsJob) {
+        op->setCredentialsJob(context.credentialsJob, context.credentialsJobFinished);
+    }
+
+    op->onSASLStatusChanged(context.status, context.error, context.errorDetails);
+    return op;
+}
+
+void XTelepathyPasswordAuthOperation::setCredentialsJob(GetCredentialsJob *job, bool finished)
+{
+    job->setParent(this);
+    m_credentialsJob = job;
+    m_credentialsJobFinished = finished;
+}
+
+void XTelepathyPasswordAuthOperation::onCredentialsFetched(KJob *job)
+{
+    if (job == m_credentialsJob) {
+        // handed over with auto-deletion off, use it only once
+        m_credentialsJob = 0;
+        job->deleteLater();
+    }
+
+    if (job->error()) {
+        qWarning() << "Credentials job error:" << job->errorText();
+        qDebug() << "Prompting for password";
+        promptUser();
+    } else {
+        m_canFinish = true;
+        QByteArray secret = qobject_cast<GetCredentialsJob*>(job)->credentialsData().value("Secret").toByteArray();
+        CredentialsCache::self()->insert(m_account->objectPath(), QLatin1String("X-TELEPATHY-PASSWORD"), secret);
+        m_saslIface->StartMechanismWithData(QLatin1String("X-TELEPATHY-PASSWORD"), secret);
+    }
+}
+
 void XTelepathyPasswordAuthOperation::promptUser()
 {
     m_dialog = new XTelepathyPasswordPrompt(m_account);
@@ -152,6 +202,8 @@ void XTelepathyPasswordAuthOperation::onDialogFinished(int result)
         if (!m_dialog.isNull()) {
             if (m_dialog.data()->savePassword()) {
                 qDebug() << "Saving password in SSO";
+                CredentialsCache::self()->insert(m_account->objectPath(), QLatin1String("X-TELEPATHY-PASSWORD"),
+                                                 m_dialog.data()->password().toUtf8());
                 m_canFinish = false;
                 storeCredentials(m_dialog.data()->password());
             } else {
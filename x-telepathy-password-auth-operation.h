@@ -26,6 +26,10 @@
 #include <KConfigGroup>
 #include <KSharedConfig>
 
+class GetCredentialsJob;
+class KJob;
+struct SaslMechanismContext;
+
 class XTelepathyPasswordAuthOperation : public Tp::PendingOperation
 {
     Q_OBJECT
@@ -39,9 +43,19 @@ public:
             bool canTryAgain);
     ~XTelepathyPasswordAuthOperation();
 
+    static Tp::PendingOperation *create(const SaslMechanismContext &context);
+
+    /**
+     * Takes over @p job, a password lookup for the account started
+     * ahead of time, instead of starting one when the mechanism starts.
+     * @p finished tells whether it already emitted finished().
+     */
+    void setCredentialsJob(GetCredentialsJob *job, bool finished);
+
 private Q_SLOTS:
     void onSASLStatusChanged(uint status, const QString &reason, const QVariantMap &details);
     void onDialogFinished(int result);
+    void onCredentialsFetched(KJob *job);
 
 private:
     void promptUser();
@@ -55,8 +69,8 @@ private:
     bool m_canTryAgain;
     bool m_canFinish;
     QPointer<XTelepathyPasswordPrompt> m_dialog;
-
-    friend class SaslAuthOp;
+    GetCredentialsJob *m_credentialsJob;
+    bool m_credentialsJobFinished;
 };
 
 
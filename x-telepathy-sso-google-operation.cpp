@@ -18,6 +18,8 @@
  *************************************************************************************/
 
 #include "x-telepathy-sso-google-operation.h"
+#include "credentials-cache.h"
+#include "sasl-mechanism-registry.h"
 
 #include <KAccounts/getcredentialsjob.h>
 #include <QDebug>
@@ -26,20 +28,41 @@
 #include <KConfigGroup>
 #include <KLocalizedString>
 
+// Preferred over the password, it needs no prompt
+static const SaslMechanismRegistration s_registration(QStringLiteral("X-OAUTH2"), 100,
+                                                      SaslMechanism::NoCapabilities,
+                                                      &XTelepathySSOGoogleOperation::create);
+
 XTelepathySSOGoogleOperation::XTelepathySSOGoogleOperation(const Tp::AccountPtr &account, int accountStorageId, Tp::Client::ChannelInterfaceSASLAuthenticationInterface *saslIface)
     : PendingOperation(account)
+    , m_account(account)
     , m_saslIface(saslIface)
     , m_accountStorageId(accountStorageId)
 {
     connect(m_saslIface, SIGNAL(SASLStatusChanged(uint,QString,QVariantMap)), SLOT(onSASLStatusChanged(uint,QString,QVariantMap)));
 }
 
+Tp::PendingOperation *XTelepathySSOGoogleOperation::create(const SaslMechanismContext &context)
+{
+    XTelepathySSOGoogleOperation *op = new XTelepathySSOGoogleOperation(context.account,
+            context.accountStorageId, context.saslIface);
+    op->onSASLStatusChanged(context.status, context.error, context.errorDetails);
+    return op;
+}
+
 void XTelepathySSOGoogleOperation::onSASLStatusChanged(uint status, const QString &reason, const QVariantMap &details)
 {
     switch (status){
     case Tp::SASLStatusNotStarted:
     {
         qDebug() << "Status Not started";
+        QByteArray data;
+        if (CredentialsCache::self()->lookup(m_account->objectPath(), QLatin1String("X-OAUTH2"), &data)) {
+            qDebug() << "Using the recently used Google credentials, starting auth mechanism...";
+            m_saslIface->StartMechanismWithData(QLatin1String("X-OAUTH2"), data);
+            break;
+        }
+
         GetCredentialsJob *job = new GetCredentialsJob(m_accountStorageId, QStringLiteral("oauth2"), QStringLiteral("web_server"), this);
         connect(job, SIGNAL(finished(KJob*)), SLOT(gotCredentials(KJob*)));
         job->start();
@@ -56,6 +79,7 @@ void XTelepathySSOGoogleOperation::onSASLStatusChanged(uint status, const QStrin
         break;
     case Tp::SASLStatusServerFailed:
         qDebug() << "Auth failed";
+        CredentialsCache::self()->invalidate(m_account->objectPath());
         QString errorMessage = details[QLatin1String("server-message")].toString();
         if (errorMessage.isEmpty()) {
             errorMessage = details[QLatin1String("debug-message")].toString();
@@ -75,6 +99,10 @@ void XTelepathySSOGoogleOperation::gotCredentials(KJob *kjob)
     data.append("\0", 1);
     data.append(credentialsData["AccessToken"].toByteArray());
 
+    if (!job->error()) {
+        CredentialsCache::self()->insert(m_account->objectPath(), QLatin1String("X-OAUTH2"), data);
+    }
+
     qDebug() << "Received Google credentials, starting auth mechanism...";
 
     m_saslIface->StartMechanismWithData(QLatin1String("X-OAUTH2"), data);
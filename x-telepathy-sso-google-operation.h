@@ -26,6 +26,7 @@
 #include <TelepathyQt/Account>
 
 class KJob;
+struct SaslMechanismContext;
 
 class XTelepathySSOGoogleOperation : public Tp::PendingOperation
 {
@@ -38,6 +39,8 @@ public:
             int accountStorageId,
             Tp::Client::ChannelInterfaceSASLAuthenticationInterface *saslIface);
 
+    static Tp::PendingOperation *create(const SaslMechanismContext &context);
+
 private Q_SLOTS:
     void onSASLStatusChanged(uint status, const QString &reason, const QVariantMap &details);
     void gotCredentials(KJob *kjob);
@@ -48,8 +51,6 @@ private:
 
     int m_accountStorageId;
     QByteArray m_challengeData;
-
-    friend class SaslAuthOp;
 };
 
 #endif //X_TELEPATHY_SSO_GOOGLE_OPERATION_H